@@ -0,0 +1,90 @@
+#include "allocation_counter.h"
+
+#ifdef COUNT_ALLOCATION
+#include <new>
+#include <cstdlib>
+
+// Replacements of the global allocation functions that count every allocation per thread.
+
+namespace {
+	void* Allocate(std::size_t size)
+	{
+		benchmark::AllocationCounter::Increase();
+		if (auto ptr = std::malloc(0 == size ? 1 : size)) {
+			return ptr;
+		}
+		throw std::bad_alloc{};
+	}
+
+	void* Allocate(std::size_t size, std::align_val_t alignment)
+	{
+		benchmark::AllocationCounter::Increase();
+		auto align = static_cast<std::size_t>(alignment);
+		size = ((0 == size ? 1 : size) + align - 1) / align * align;
+		if (auto ptr = std::aligned_alloc(align, size)) {
+			return ptr;
+		}
+		throw std::bad_alloc{};
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return Allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return Allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return Allocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace benchmark {
+	/* Counts calls to the global operator new when built with COUNT_ALLOCATION.
+	Otherwise every member compiles to nothing. */
+	class AllocationCounter {
+	public:
+#ifdef COUNT_ALLOCATION
+		static constexpr bool kIsEnabled{ true };
+#else
+		static constexpr bool kIsEnabled{ false };
+#endif
+
+		static void Increase() noexcept {
+			num_thread_allocation_ += 1;
+		}
+
+		// Number of allocations made by the calling thread so far.
+		static uint64_t GetThreadCount() noexcept {
+			return num_thread_allocation_;
+		}
+
+		static void AddToTotal(uint64_t num_allocation) noexcept {
+			if constexpr (kIsEnabled) {
+				num_total_allocation_.fetch_add(num_allocation, std::memory_order_relaxed);
+			}
+		}
+
+		static uint64_t ResetTotal() noexcept {
+			return num_total_allocation_.exchange(0, std::memory_order_relaxed);
+		}
+
+	private:
+		static thread_local uint64_t num_thread_allocation_;
+		static std::atomic<uint64_t> num_total_allocation_;
+	};
+
+	inline thread_local uint64_t AllocationCounter::num_thread_allocation_{};
+	inline std::atomic<uint64_t> AllocationCounter::num_total_allocation_{};
+}
+
+#endif
\ No newline at end of file
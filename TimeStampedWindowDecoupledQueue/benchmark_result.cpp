@@ -1,50 +1,144 @@
 #include <format>
 #include "benchmark_result.h"
+#include "allocation_counter.h"
 
 namespace benchmark {
-	void ResultMap::PrintResult(bool checks_relaxation_distance,
-		bool scales_with_depth, int32_t num_op) const
+	void ResultMap::PrintResult(Mode mode, Scaling scaling, int32_t num_op) const
 	{
 		for (auto i = cbegin(); i != cend(); ++i) {
-			if (scales_with_depth) {
-				compat::Print("k-relaxation: {:5}", i->first);
-			} else {
-				compat::Print("threads: {:2}", i->first);
-			}
+			PrintKey(scaling, i->first);
 			compat::Print("  |  ");
 
 			auto& results = i->second;
 
-			if (checks_relaxation_distance) {
-				auto total_element = std::accumulate(results.begin(), results.end(), uint64_t{}, [](uint64_t acc, const Result& r) {
-					return acc + r.num_element;
-					});
-
-				auto sum_rd = std::accumulate(results.begin(), results.end(), uint64_t{}, [](uint64_t acc, const Result& r) {
-					return acc + r.sum_relaxation_distance;
-					});
-				auto avg_dist = static_cast<double>(sum_rd) / total_element;
-				compat::Print("avg dist: {:7.2f}\n", avg_dist);
-			} else {
+			if (Mode::kRelaxation == mode) {
+				PrintRelaxationDistance(results);
+				compat::Print("\n");
+			} else if (Mode::kIdle == mode) {
 				auto avg_sec = std::accumulate(results.begin(), results.end(), 0.0, [](double acc, const Result& r) {
 					return acc + r.elapsed_sec;
 					}) / results.size();
-				auto throughput = num_op / 1e6 / avg_sec;
-				compat::Print("avg throughput: {:5.2f} MOp/s\n", throughput);
+				auto avg_cpu_sec = std::accumulate(results.begin(), results.end(), 0.0, [](double acc, const Result& r) {
+					return acc + r.cpu_sec;
+					}) / results.size();
+				compat::Print("avg wall time: {:5.2f} sec  |  avg cpu time: {:6.2f} sec  |  busy cores: {:5.2f}\n",
+					avg_sec, avg_cpu_sec, avg_cpu_sec / avg_sec);
+			} else if (Mode::kStall == mode or Mode::kReclamation == mode) {
+				for (auto reclamation : { Reclamation::kEBR, Reclamation::kHazardPointer, Reclamation::kHazardEra }) {
+					std::vector<Result> reclaimed;
+					std::copy_if(results.begin(), results.end(), std::back_inserter(reclaimed), [reclamation](const Result& r) {
+						return reclamation == r.reclamation;
+						});
+					compat::Print("\n  {:>15}: ", GetReclamationName(reclamation));
+					PrintThroughput(reclaimed, num_op);
+					if (Mode::kStall == mode) {
+						auto peak = std::accumulate(reclaimed.begin(), reclaimed.end(), uint64_t{}, [](uint64_t acc, const Result& r) {
+							return std::max(acc, r.peak_unreclaimed);
+							});
+						compat::Print("  |  peak unreclaimed: {:9}", peak);
+					} else {
+						auto avg_sec = std::accumulate(reclaimed.begin(), reclaimed.end(), 0.0, [](double acc, const Result& r) {
+							return acc + r.elapsed_sec;
+							}) / reclaimed.size();
+						compat::Print("  |  per-thread time: {:6.1f} ns/op", avg_sec * i->first / num_op * 1e9);
+					}
+				}
+				compat::Print("\n");
+			} else if (Mode::kLatency == mode) {
+				for (auto reclamation : { Reclamation::kEBR, Reclamation::kEBRBackground }) {
+					std::vector<Result> reclaimed;
+					std::copy_if(results.begin(), results.end(), std::back_inserter(reclaimed), [reclamation](const Result& r) {
+						return reclamation == r.reclamation;
+						});
+					compat::Print("\n  {:>16}: ", GetReclamationName(reclamation));
+					PrintThroughput(reclaimed, num_op);
+					compat::Print("  |  deq latency:");
+					for (size_t j = 0; j < kLatencyPercentiles.size(); ++j) {
+						auto avg_ns = std::accumulate(reclaimed.begin(), reclaimed.end(), 0.0, [j](double acc, const Result& r) {
+							return acc + r.latency_ns[j];
+							}) / reclaimed.size();
+						compat::Print("  p{}: {:.0f} ns", kLatencyPercentiles[j], avg_ns);
+					}
+					auto max_ns = std::accumulate(reclaimed.begin(), reclaimed.end(), uint64_t{}, [](uint64_t acc, const Result& r) {
+						return std::max(acc, r.latency_ns.back());
+						});
+					compat::Print("  max: {} ns", max_ns);
+				}
+				compat::Print("\n");
+			} else if (Mode::kHandle == mode) {
+				for (auto uses_handle : { false, true }) {
+					std::vector<Result> accessed;
+					std::copy_if(results.begin(), results.end(), std::back_inserter(accessed), [uses_handle](const Result& r) {
+						return uses_handle == r.uses_handle;
+						});
+					compat::Print("\n  {:>9}: ", uses_handle ? "handle" : "thread ID");
+					PrintThroughput(accessed, num_op);
+				}
+				compat::Print("\n");
+			} else if (Mode::kCapacity == mode) {
+				for (auto enq_rate : { 50.0f, 70.0f }) {
+					std::array<double, 2> avg_sec{};
+					for (auto is_bounded : { false, true }) {
+						std::vector<Result> bounded;
+						std::copy_if(results.begin(), results.end(), std::back_inserter(bounded), [=](const Result& r) {
+							return enq_rate == r.enq_rate and is_bounded == r.is_bounded;
+							});
+						avg_sec[is_bounded] = std::accumulate(bounded.begin(), bounded.end(), 0.0, [](double acc, const Result& r) {
+							return acc + r.elapsed_sec;
+							}) / bounded.size();
+						compat::Print("\n  {:2.0f}% enq, {:>9}: ", enq_rate, is_bounded ? "bounded" : "unbounded");
+						PrintThroughput(bounded, num_op);
+					}
+					compat::Print("\n  {:2.0f}% enq, capacity overhead: {:+.1f}% time per op", enq_rate, (avg_sec[1] / avg_sec[0] - 1.0) * 100.0);
+				}
+				compat::Print("\n");
+			} else if (Mode::kInstrumentation == mode) {
+				for (auto is_instrumented : { true, false }) {
+					std::vector<Result> instrumented;
+					std::copy_if(results.begin(), results.end(), std::back_inserter(instrumented), [is_instrumented](const Result& r) {
+						return is_instrumented == r.is_instrumented;
+						});
+					compat::Print("\n  {:>13}: ", is_instrumented ? "runtime check" : "compiled out");
+					PrintThroughput(instrumented, num_op);
+				}
+				compat::Print("\n");
+			} else if (Placement::kNone == results.front().placement) {
+				PrintThroughput(results, num_op);
+				if (Mode::kCacheMiss == mode) {
+					PrintCacheMiss(results, num_op);
+				} else if (Mode::kSampling == mode) {
+					compat::Print("  |  sampled ");
+					PrintRelaxationDistance(results);
+				}
+				compat::Print("\n");
+			} else {
+				for (auto placement : { Placement::kLocal, Placement::kInterleaved }) {
+					std::vector<Result> placed;
+					std::copy_if(results.begin(), results.end(), std::back_inserter(placed), [placement](const Result& r) {
+						return placement == r.placement;
+						});
+					compat::Print("{}: ", GetPlacementName(placement));
+					PrintThroughput(placed, num_op);
+					if (Mode::kCacheMiss == mode) {
+						PrintCacheMiss(placed, num_op);
+					} else if (Mode::kSampling == mode) {
+						compat::Print("  |  sampled ");
+						PrintRelaxationDistance(placed);
+					}
+					if (Placement::kLocal == placement) {
+						compat::Print("  |  ");
+					}
+				}
+				compat::Print("\n");
 			}
 		}
 		compat::Print("\n");
 	}
 
-	void ResultMap::PrintResult(bool scales_with_depth, int32_t distance) const
+	void ResultMap::PrintResult(Scaling scaling, int32_t distance) const
 	{
 		for (auto i = cbegin(); i != cend(); ++i) {
-			if (scales_with_depth) {
-				compat::Print("k-relaxation: {:5}", i->first);
-				
-			} else {
-				compat::Print("threads: {:2}", i->first);
-			}
+			PrintKey(scaling, i->first);
 
 			auto& results = i->second;
 
@@ -64,19 +158,25 @@ namespace benchmark {
 		compat::Print("\n");
 	}
 
-	void ResultMap::Save(bool checks_relaxation_distance, bool scales_with_depth,
+	void ResultMap::Save(Mode mode, Scaling scaling,
 		float enq_rate, Subject subject, int parameter, int width)
 	{
 		file_ << std::format("subject: {}, ", GetSubjectName(subject));
-		if ((Subject::k2Dd == subject or Subject::kCBO == subject) and width != 0) {
+		if ((Subject::k2Dd == subject or Subject::kCBO == subject or Subject::kTSWDMP == subject) and width != 0) {
 			file_ << std::format("width: {}, ", width);
 
 		} else {
 			file_ << std::format("width: nbr thread, ");
 		}
 
-		if (scales_with_depth) {
+		if (Scaling::kDepth == scaling) {
 			file_ << "k-relaxation: ";
+		} else if (Scaling::kPayload == scaling) {
+			file_ << std::format("parameter: {}, ", parameter);
+			file_ << "payload bytes: ";
+		} else if (Scaling::kWidth == scaling) {
+			file_ << std::format("parameter: {}, ", parameter);
+			file_ << "width: ";
 		} else {
 			file_ << std::format("parameter: {}, ", parameter);
 			file_ << "threads: ";
@@ -88,46 +188,225 @@ namespace benchmark {
 		}
 		file_ << '\n';
 
-		if (checks_relaxation_distance) {
-			file_ << "dequeued elements|sum dist|max dist|\n";
+		if (Mode::kRelaxation == mode) {
+			file_ << "dequeued elements|sum dist|max dist|p50 dist|p90 dist|p99 dist|p99.9 dist|\n";
+		} else if (Mode::kIdle == mode) {
+			file_ << "elapsed sec|cpu sec|\n";
+		} else if (Mode::kStall == mode) {
+			file_ << "elapsed sec|peak unreclaimed| (EBR, then hazard pointers, then hazard eras)\n";
+		} else if (Mode::kReclamation == mode) {
+			file_ << "elapsed sec (EBR, then hazard pointers, then hazard eras)\n";
+		} else if (Mode::kLatency == mode) {
+			file_ << "elapsed sec|p50 ns|p99 ns|p99.9 ns|p99.99 ns|max ns| (inline EBR, then background EBR)\n";
+		} else if (Mode::kCacheMiss == mode) {
+			file_ << "elapsed sec|cache misses|L1D load misses|\n";
+		} else if (Mode::kHandle == mode) {
+			file_ << "elapsed sec (thread ID, then handle)\n";
+		} else if (Mode::kCapacity == mode) {
+			file_ << "elapsed sec (50% enq unbounded, 50% enq bounded, 70% enq unbounded, 70% enq bounded)\n";
+		} else if (Mode::kInstrumentation == mode) {
+			file_ << "elapsed sec (runtime check, then compiled out)\n";
+		} else if (Mode::kSampling == mode) {
+			file_ << "elapsed sec|sampled elements|sum dist|max dist|p50 dist|p90 dist|p99 dist|p99.9 dist|\n";
+		} else if (not empty() and Placement::kNone != begin()->second.front().placement) {
+			file_ << "elapsed sec (socket-local, then interleaved)\n";
 		} else {
 			file_ << "elapsed sec\n";
 		}
 
 		for (auto& [key, results] : *this) {
-			if (checks_relaxation_distance) {
+			if (Mode::kRelaxation == mode) {
+				SaveRelaxationDistanceColumns(results);
+			} else if (Mode::kSampling == mode) {
 				for (auto& result : results) {
-					file_ << std::format("{}|", result.num_element);
+					file_ << std::format("{:.6f}|", result.elapsed_sec);
 				}
+				SaveRelaxationDistanceColumns(results);
+			} else if (Mode::kIdle == mode) {
 				for (auto& result : results) {
-					file_ << std::format("{}|", result.sum_relaxation_distance);
+					file_ << std::format("{:.6f}|", result.elapsed_sec);
 				}
 				for (auto& result : results) {
-					file_ << std::format("{}|", result.max_relaxation_distance);
+					file_ << std::format("{:.6f}|", result.cpu_sec);
 				}
-			} else {
+			} else if (Mode::kStall == mode or Mode::kReclamation == mode) {
+				for (auto reclamation : { Reclamation::kEBR, Reclamation::kHazardPointer, Reclamation::kHazardEra }) {
+					for (auto& result : results) {
+						if (reclamation == result.reclamation) {
+							file_ << std::format("{:.6f}|", result.elapsed_sec);
+						}
+					}
+					for (auto& result : results) {
+						if (Mode::kStall == mode and reclamation == result.reclamation) {
+							file_ << std::format("{}|", result.peak_unreclaimed);
+						}
+					}
+				}
+			} else if (Mode::kLatency == mode) {
+				for (auto reclamation : { Reclamation::kEBR, Reclamation::kEBRBackground }) {
+					for (auto& result : results) {
+						if (reclamation == result.reclamation) {
+							file_ << std::format("{:.6f}|", result.elapsed_sec);
+						}
+					}
+					for (size_t j = 0; j < kLatencyPercentiles.size() + 1; ++j) {
+						for (auto& result : results) {
+							if (reclamation == result.reclamation) {
+								file_ << std::format("{}|", result.latency_ns[j]);
+							}
+						}
+					}
+				}
+			} else if (Mode::kCacheMiss == mode) {
 				for (auto& result : results) {
 					file_ << std::format("{:.6f}|", result.elapsed_sec);
 				}
+				for (auto& result : results) {
+					file_ << std::format("{}|", result.num_cache_miss);
+				}
+				for (auto& result : results) {
+					file_ << std::format("{}|", result.num_l1d_miss);
+				}
+			} else if (Mode::kHandle == mode) {
+				for (auto uses_handle : { false, true }) {
+					for (auto& result : results) {
+						if (uses_handle == result.uses_handle) {
+							file_ << std::format("{:.6f}|", result.elapsed_sec);
+						}
+					}
+				}
+			} else if (Mode::kCapacity == mode) {
+				for (auto enq_rate : { 50.0f, 70.0f }) {
+					for (auto is_bounded : { false, true }) {
+						for (auto& result : results) {
+							if (enq_rate == result.enq_rate and is_bounded == result.is_bounded) {
+								file_ << std::format("{:.6f}|", result.elapsed_sec);
+							}
+						}
+					}
+				}
+			} else if (Mode::kInstrumentation == mode) {
+				for (auto is_instrumented : { true, false }) {
+					for (auto& result : results) {
+						if (is_instrumented == result.is_instrumented) {
+							file_ << std::format("{:.6f}|", result.elapsed_sec);
+						}
+					}
+				}
+			} else {
+				for (auto placement : { Placement::kNone, Placement::kLocal, Placement::kInterleaved }) {
+					for (auto& result : results) {
+						if (placement == result.placement) {
+							file_ << std::format("{:.6f}|", result.elapsed_sec);
+						}
+					}
+				}
 			}
 			file_ << '\n';
 		}
 
 		file_ << std::format("\n\n");
+
+		if (Mode::kRelaxation == mode or Mode::kSampling == mode) {
+			SaveRelaxationDistances(scaling, enq_rate, subject, parameter);
+		}
+	}
+
+	void ResultMap::SaveRelaxationDistanceColumns(const std::vector<Result>& results)
+	{
+		for (auto& result : results) {
+			file_ << std::format("{}|", result.num_element);
+		}
+		for (auto& result : results) {
+			file_ << std::format("{}|", result.sum_relaxation_distance);
+		}
+		for (auto& result : results) {
+			file_ << std::format("{}|", result.max_relaxation_distance);
+		}
+		for (size_t j = 0; j < kRelaxationPercentiles.size(); ++j) {
+			for (auto& result : results) {
+				file_ << std::format("{}|", result.relaxation_distance.total.GetPercentiles()[j]);
+			}
+		}
+	}
+
+	/* Writes the histogram of every run next to log.txt with the percentiles
+	of the run, of each dequeuing thread and of each partial queue. */
+	void ResultMap::SaveRelaxationDistances(Scaling scaling, float enq_rate, Subject subject, int parameter)
+	{
+		std::ofstream file{ kRelaxationDistanceFileName, std::ios::app };
+		file << std::format("subject: {}, parameter: {}, enq rate: {}\n", GetSubjectName(subject), parameter, enq_rate);
+
+		for (auto& [key, results] : *this) {
+			for (size_t i = 0; i < results.size(); ++i) {
+				const auto& report = results[i].relaxation_distance;
+
+				if (Scaling::kDepth == scaling) {
+					file << std::format("k-relaxation: {}", key);
+				} else if (Scaling::kPayload == scaling) {
+					file << std::format("payload bytes: {}", key);
+				} else if (Scaling::kWidth == scaling) {
+					file << std::format("width: {}", key);
+				} else {
+					file << std::format("threads: {}", key);
+				}
+				file << std::format(", run: {}/{}\n", i + 1, results.size());
+
+				file << "scope|dequeued elements|avg dist|p50 dist|p90 dist|p99 dist|p99.9 dist|max dist|\n";
+				SaveRelaxationDistance(file, report.total, "total");
+				for (const auto& [thread, histogram] : report.per_thread) {
+					SaveRelaxationDistance(file, histogram, std::format("thread {}", thread));
+				}
+				for (size_t j = 0; j < report.per_queue.size(); ++j) {
+					SaveRelaxationDistance(file, report.per_queue[j], std::format("queue {}", j));
+				}
+
+				if (report.bound.has_value()) {
+					file << std::format("bound: {}, tolerance: {}, within tolerance: {}, violations: {}\n",
+						*report.bound, report.tolerance, report.num_within_tolerance, report.num_violation);
+					if (not report.violations.empty()) {
+						file << "dequeue|thread|queue|dist|first enq or priority|last enq or priority|first enq ns|dequeue ns|\n";
+					}
+					for (const auto& violation : report.violations) {
+						file << std::format("{}|{}|{}|{}|{}|{}|{}|{}|\n", violation.deq_index, violation.thread,
+							violation.queue, violation.rd, violation.first, violation.last,
+							violation.first_ns, violation.deq_ns);
+					}
+				}
+
+				file << "dist|dequeued elements|\n";
+				for (auto [rd, cnt] : report.total.GetCounts()) {
+					file << std::format("{}|{}|\n", rd, cnt);
+				}
+				file << '\n';
+			}
+		}
+		file << '\n';
 	}
 
-	void ResultMap::Save(bool scales_with_depth, Graph::Type graph,
+	void ResultMap::SaveRelaxationDistance(std::ostream& file, const RelaxationDistanceHistogram& histogram,
+		const std::string& scope)
+	{
+		file << std::format("{}|{}|{:.4f}|", scope, histogram.GetNumElement(),
+			static_cast<double>(histogram.GetSum()) / std::max<uint64_t>(histogram.GetNumElement(), 1));
+		for (auto percentile : histogram.GetPercentiles()) {
+			file << std::format("{}|", percentile);
+		}
+		file << '\n';
+	}
+
+	void ResultMap::Save(Scaling scaling, Graph::Type graph,
 		Subject subject, int parameter, int width)
 	{
 		file_ << std::format("subject: {}, ", GetSubjectName(subject));
-		if ((Subject::k2Dd == subject or Subject::kCBO == subject) and width != 0) {
+		if ((Subject::k2Dd == subject or Subject::kCBO == subject or Subject::kTSWDMP == subject) and width != 0) {
 			file_ << std::format("width: {}, ", width);
 
 		} else {
 			file_ << std::format("width: nbr thread, ");
 		}
 
-		if (scales_with_depth) {
+		if (Scaling::kDepth == scaling) {
 			file_ << "k-relaxation: ";
 		} else {
 			file_ << std::format("parameter: {}, ", parameter);
@@ -151,4 +430,78 @@ namespace benchmark {
 		}
 		file_ << "\n\n";
 	}
+
+	void ResultMap::PrintThroughput(const std::vector<Result>& results, int32_t num_op)
+	{
+		auto avg_sec = std::accumulate(results.begin(), results.end(), 0.0, [](double acc, const Result& r) {
+			return acc + r.elapsed_sec;
+			}) / results.size();
+		auto throughput = num_op / 1e6 / avg_sec;
+		compat::Print("avg throughput: {:5.2f} MOp/s", throughput);
+
+		auto num_allocation = std::accumulate(results.begin(), results.end(), uint64_t{}, [](uint64_t acc, const Result& r) {
+			return acc + r.num_allocation;
+			});
+		auto allocs_per_op = static_cast<double>(num_allocation) / num_op / results.size();
+		compat::Print("  |  node allocs/op: {:.4f}", allocs_per_op);
+
+		if constexpr (AllocationCounter::kIsEnabled) {
+			auto num_heap_allocation = std::accumulate(results.begin(), results.end(), uint64_t{}, [](uint64_t acc, const Result& r) {
+				return acc + r.num_heap_allocation;
+				});
+			auto heap_allocs_per_op = static_cast<double>(num_heap_allocation) / num_op / results.size();
+			compat::Print("  |  heap allocs/op: {:.4f}", heap_allocs_per_op);
+		}
+	}
+
+	void ResultMap::PrintKey(Scaling scaling, int key)
+	{
+		switch (scaling) {
+			case Scaling::kDepth: {
+				compat::Print("k-relaxation: {:5}", key);
+				break;
+			}
+			case Scaling::kPayload: {
+				compat::Print("payload: {:3} B", key);
+				break;
+			}
+			case Scaling::kWidth: {
+				compat::Print("width: {:3}", key);
+				break;
+			}
+			default: {
+				compat::Print("threads: {:2}", key);
+				break;
+			}
+		}
+	}
+
+	// Merges the histograms of the repetitions.
+	void ResultMap::PrintRelaxationDistance(const std::vector<Result>& results)
+	{
+		RelaxationDistanceHistogram histogram;
+		for (const auto& result : results) {
+			histogram.Merge(result.relaxation_distance.total);
+		}
+		auto avg_dist = static_cast<double>(histogram.GetSum()) / histogram.GetNumElement();
+		compat::Print("avg dist: {:7.2f}  |", avg_dist);
+
+		auto percentiles = histogram.GetPercentiles();
+		for (size_t j = 0; j < kRelaxationPercentiles.size(); ++j) {
+			compat::Print("  p{}: {:4}", kRelaxationPercentiles[j], percentiles[j]);
+		}
+		compat::Print("  max: {}", percentiles.back());
+	}
+
+	void ResultMap::PrintCacheMiss(const std::vector<Result>& results, int32_t num_op)
+	{
+		auto num_cache_miss = std::accumulate(results.begin(), results.end(), uint64_t{}, [](uint64_t acc, const Result& r) {
+			return acc + r.num_cache_miss;
+			});
+		auto num_l1d_miss = std::accumulate(results.begin(), results.end(), uint64_t{}, [](uint64_t acc, const Result& r) {
+			return acc + r.num_l1d_miss;
+			});
+		compat::Print("  |  cache misses/op: {:.3f}", static_cast<double>(num_cache_miss) / num_op / results.size());
+		compat::Print("  |  L1D misses/op: {:.3f}", static_cast<double>(num_l1d_miss) / num_op / results.size());
+	}
 }
\ No newline at end of file
@@ -2,44 +2,84 @@
 #define BENCHMARK_RESULT_H
 
 #include <map>
+#include <array>
 #include <vector>
 #include <fstream>
 #include <numeric>
 #include "subject_type.h"
+#include "scaling_type.h"
+#include "mode_type.h"
+#include "placement_type.h"
+#include "reclamation_type.h"
 #include "graph.h"
+#include "relaxation_distance.h"
 #include "print.h"
 
 namespace benchmark {
+	// Percentiles of the dequeue latency in latency mode.
+	inline constexpr std::array<double, 4> kLatencyPercentiles{ 50.0, 99.0, 99.9, 99.99 };
+
 	struct Result {
 		Result() = default;
-		Result(double elapsed_sec, uint64_t num_element, uint64_t sum_rd, uint64_t max_rd)
+		Result(double elapsed_sec, uint64_t num_element, uint64_t sum_rd, uint64_t max_rd,
+			uint64_t num_allocation, uint64_t num_heap_allocation)
 			: elapsed_sec{ elapsed_sec }, num_element{ num_element }
-			, sum_relaxation_distance{ sum_rd }, max_relaxation_distance{ max_rd } {}
+			, sum_relaxation_distance{ sum_rd }, max_relaxation_distance{ max_rd }
+			, num_allocation{ num_allocation }, num_heap_allocation{ num_heap_allocation } {}
 
 		Result(double elapsed_sec, int32_t distance)
 			: elapsed_sec{ elapsed_sec }, distance{ distance } {}
 
+		Result(double elapsed_sec, double cpu_sec)
+			: elapsed_sec{ elapsed_sec }, cpu_sec{ cpu_sec } {}
+
 		double elapsed_sec{};
+		double cpu_sec{};
 		uint64_t num_element{};
 		uint64_t sum_relaxation_distance{};
 		uint64_t max_relaxation_distance{};
+		uint64_t num_allocation{};
+		uint64_t num_heap_allocation{};
 		int32_t distance{};
+		Placement placement{};
+		Reclamation reclamation{};
+		uint64_t peak_unreclaimed{};
+		uint64_t num_cache_miss{};
+		uint64_t num_l1d_miss{};
+		bool uses_handle{};
+		bool is_instrumented{};
+		bool is_bounded{};
+		float enq_rate{};
+		// The percentiles followed by the maximum.
+		std::array<uint64_t, kLatencyPercentiles.size() + 1> latency_ns{};
+		RelaxationDistanceReport relaxation_distance{};
 	};
 
 	class ResultMap : public std::map<int, std::vector<Result>>{
 	public:
 		ResultMap() = default;
-		void PrintResult(bool checks_relaxation_distance,
-			bool scales_with_depth, int32_t num_op) const;
-		void PrintResult(bool scales_with_depth, int32_t distance) const;
+		void PrintResult(Mode mode, Scaling scaling, int32_t num_op) const;
+		void PrintResult(Scaling scaling, int32_t distance) const;
 
-		void Save(bool checks_relaxation_distance, bool scales_with_depth,
+		void Save(Mode mode, Scaling scaling,
 			float enq_rate, Subject subject, int parameter, int width);
 
-		void Save(bool scales_with_depth, Graph::Type graph, Subject subject, int parameter, int width);
+		void Save(Scaling scaling, Graph::Type graph, Subject subject, int parameter, int width);
 
 	private:
+		static void PrintKey(Scaling scaling, int key);
+		static void PrintThroughput(const std::vector<Result>& results, int32_t num_op);
+		static void PrintCacheMiss(const std::vector<Result>& results, int32_t num_op);
+		static void PrintRelaxationDistance(const std::vector<Result>& results);
+		static void SaveRelaxationDistance(std::ostream& file, const RelaxationDistanceHistogram& histogram,
+			const std::string& scope);
+
+		void SaveRelaxationDistanceColumns(const std::vector<Result>& results);
+		void SaveRelaxationDistances(Scaling scaling, float enq_rate, Subject subject, int parameter);
+
 		std::ofstream file_{ "log.txt", std::ios::app };
+		// Written next to log.txt by the relaxation distance check only.
+		static constexpr const char* kRelaxationDistanceFileName{ "relaxation_distance.txt" };
 	};
 }
 
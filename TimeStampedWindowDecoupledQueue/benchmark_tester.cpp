@@ -6,6 +6,11 @@
 #include "ts_stutter.h"
 #include "twodd.h"
 #include "tswd.h"
+#include "hazard_pointer.h"
+#include "hazard_era.h"
+#include "tswd_mp.h"
+#include "tswd_pq.h"
+#include "tswd_stack.h"
 
 namespace benchmark {
 	void Tester::Run()
@@ -28,11 +33,11 @@ namespace benchmark {
 					break;
 				}
 				case 'm': {
-					CheckRelaxationDistance();
+					ChangeMode();
 					break;
 				}
 				case 'c': {
-					ScaleWithDepth();
+					ChangeScaling();
 					break;
 				}
 				case 's': {
@@ -51,6 +56,30 @@ namespace benchmark {
 					SetDelay();
 					break;
 				}
+				case 'n': {
+					SetAllocation();
+					break;
+				}
+				case 'u': {
+					SetNuma();
+					break;
+				}
+				case 'b': {
+					SetCapacity();
+					break;
+				}
+				case 'r': {
+					SetMaxRelaxationBound();
+					break;
+				}
+				case 'f': {
+					SetReclaiming();
+					break;
+				}
+				case 'k': {
+					SetBoundCheck();
+					break;
+				}
 				case 'i': {
 					RunMicroBenchmark();
 					break;
@@ -83,7 +112,50 @@ namespace benchmark {
 
 	void Tester::RunMicroBenchmark()
 	{
-		if (not HasValidParameter()) {
+		if (Mode::kReclamation != mode_ and not HasValidParameter()) {
+			return;
+		}
+
+		if (Mode::kReclamation == mode_ and Scaling::kThread != scaling_) {
+			compat::Print("[Error] The reclamation overhead is only measured scaling with threads.\n\n");
+			return;
+		}
+
+		if (Mode::kStall == mode_ and Subject::kTSWD != subject_) {
+			compat::Print("[Error] The stalled-thread mode is only for TSWD.\n\n");
+			return;
+		}
+
+		if (Mode::kInstrumentation == mode_
+			and Subject::kCBO != subject_ and Subject::k2Dd != subject_ and Subject::kTSWD != subject_
+			and Subject::kTSWDMP != subject_ and Subject::kTSWDPQ != subject_ and Subject::kTSWDStack != subject_) {
+			compat::Print("[Error] The instrumentation mode is only for d-CBO, 2Dd and the TSWD variants.\n\n");
+			return;
+		}
+
+		if (Mode::kHandle == mode_ and Subject::kTSWD != subject_) {
+			compat::Print("[Error] The handle mode is only for TSWD.\n\n");
+			return;
+		}
+
+		if (Mode::kCapacity == mode_ and (Subject::kTSWD != subject_ or 0 == capacity_)) {
+			compat::Print("[Error] The capacity mode is only for TSWD with a capacity set by 'b'.\n\n");
+			return;
+		}
+
+		if (Mode::kSampling == mode_ and (Subject::kTSWDPQ == subject_ or Subject::kTSWDStack == subject_)) {
+			compat::Print("[Error] The sampling mode estimates the FIFO rank error, which TSWD-PQ and TSWD-stack do not have.\n\n");
+			return;
+		}
+
+		if (checks_bound_ and Mode::kRelaxation == mode_ and Subject::k2Dd != subject_
+			and Subject::kTSWD != subject_ and Subject::kTSWDMP != subject_ and Subject::kTSWDPQ != subject_) {
+			compat::Print("[Error] The bound check is only for 2Dd, TSWD, TSWD-MP or TSWD-PQ, whose relaxation bound is deterministic.\n\n");
+			return;
+		}
+
+		if (Mode::kLatency == mode_ and Subject::kTSWDPQ == subject_) {
+			compat::Print("[Error] The latency mode compares EBR settings, which TSWD-PQ does not use.\n\n");
 			return;
 		}
 
@@ -97,18 +169,51 @@ namespace benchmark {
 
 		for (int i = 1; i <= num_repeat; ++i) {
 			compat::Print("---------- {}/{} ----------\n", i, num_repeat);
-			if (scales_with_depth_) {
-				if (false == RunMicroBenchmarkScalingWithDepth()) {
-					return;
-				}
-			} else {
-				if (false == RunMicroBenchmarkScalingWithThread()) {
-					return;
-				}
+			auto is_valid = Mode::kLatency == mode_ ? RunMicroBenchmarkWithReclaiming() : RunMicroBenchmarkScaling();
+			if (false == is_valid) {
+				return;
 			}
 		}
-		results.PrintResult(checks_relaxation_distance_, scales_with_depth_, kTotalNumOp);
-		results.Save(checks_relaxation_distance_, scales_with_depth_, enq_rate_, subject_, parameter_, width_);
+		results.PrintResult(mode_, scaling_, kTotalNumOp);
+		results.Save(mode_, scaling_, enq_rate_, subject_, parameter_, width_);
+	}
+
+	bool Tester::RunMicroBenchmarkScaling()
+	{
+		switch (scaling_) {
+			case Scaling::kThread: {
+				return Mode::kReclamation == mode_ ? RunReclamationBenchmark() : RunMicroBenchmarkScalingWithThread();
+			}
+			case Scaling::kDepth: {
+				return RunMicroBenchmarkScalingWithDepth();
+			}
+			case Scaling::kPayload: {
+				return RunMicroBenchmarkScalingWithPayload();
+			}
+			case Scaling::kWidth: {
+				return RunMicroBenchmarkScalingWithWidth();
+			}
+		}
+		return false;
+	}
+
+	// Runs every case with EBR reclaiming inline, then on a background thread.
+	bool Tester::RunMicroBenchmarkWithReclaiming()
+	{
+		auto reclaiming = lf::ebr_reclaiming;
+
+		lf::ebr_reclaiming = lf::Reclaiming::kInline;
+		reclamation_ = Reclamation::kEBR;
+		auto is_valid = RunMicroBenchmarkScaling();
+		if (is_valid) {
+			lf::ebr_reclaiming = lf::Reclaiming::kBackground;
+			reclamation_ = Reclamation::kEBRBackground;
+			is_valid = RunMicroBenchmarkScaling();
+		}
+
+		lf::ebr_reclaiming = reclaiming;
+		reclamation_ = Reclamation::kNone;
+		return is_valid;
 	}
 
 	void Tester::RunMacroBenchmark()
@@ -121,6 +226,11 @@ namespace benchmark {
 			compat::Print("[Error] Generate or load graph first.\n\n");
 			return;
 		}
+
+		if (Scaling::kPayload == scaling_ or Scaling::kWidth == scaling_) {
+			compat::Print("[Error] 'Scaling with {}' mode is only for the microbenchmark.\n\n", GetScalingName(scaling_));
+			return;
+		}
 		
 		compat::Print("Input the number of times to repeat: ");
 		auto num_repeat{ InputNumber<int>() };
@@ -133,7 +243,7 @@ namespace benchmark {
 
 		for (int i = 1; i <= num_repeat; ++i) {
 			compat::Print("---------- {}/{} ----------\n", i, num_repeat);
-			if (scales_with_depth_) {
+			if (Scaling::kDepth == scaling_) {
 				if (false == RunMacroBenchmarkScalingWithDepth()) {
 					return;
 				}
@@ -143,8 +253,8 @@ namespace benchmark {
 				}
 			}
 		}
-		results.PrintResult(scales_with_depth_, graph_->GetShortestDistance());
-		results.Save(scales_with_depth_, graph_->GetType(), subject_, parameter_, width_);
+		results.PrintResult(scaling_, graph_->GetShortestDistance());
+		results.Save(scaling_, graph_->GetType(), subject_, parameter_, width_);
 	}
 
 	bool Tester::RunMicroBenchmarkScalingWithThread()
@@ -157,7 +267,7 @@ namespace benchmark {
 					break;
 				}
 				case Subject::kTSStutter: {
-					lf::ts_atomic::TSAtomic subject{ num_thread };
+					lf::ts_stutter::TSStutter subject{ num_thread };
 					Measure(MicrobenchmarkFunc, num_thread, subject);
 					break;
 				}
@@ -173,19 +283,29 @@ namespace benchmark {
 				}
 				case Subject::kCBO: {
 					auto width = 0 == width_ ? num_thread : width_;
-					lf::cbo::CBO subject{ width, num_thread, parameter_ };
-					Measure(MicrobenchmarkFunc, num_thread, subject);
+					MeasureInstrumented<lf::cbo::CBO>(num_thread, width, num_thread, parameter_);
 					break;
 				}
 				case Subject::k2Dd: {
 					auto width = 0 == width_ ? num_thread : width_;
-					lf::twodd::TwoDd subject{ width, num_thread, parameter_ };
-					Measure(MicrobenchmarkFunc, num_thread, subject);
+					MeasureInstrumented<lf::twodd::TwoDd>(num_thread, width, num_thread, parameter_);
 					break;
 				}
 				case Subject::kTSWD: {
-					lf::tswd::TSWD subject{ num_thread, parameter_ };
-					Measure(MicrobenchmarkFunc, num_thread, subject);
+					MeasureTSWD(num_thread, num_thread, parameter_);
+					break;
+				}
+				case Subject::kTSWDMP: {
+					auto width = 0 == width_ ? num_thread : width_;
+					MeasureInstrumented<lf::tswd_mp::TSWDMP>(num_thread, width, num_thread, parameter_);
+					break;
+				}
+				case Subject::kTSWDPQ: {
+					MeasureInstrumented<lf::tswd_pq::TSWDPQ>(num_thread, num_thread, parameter_);
+					break;
+				}
+				case Subject::kTSWDStack: {
+					MeasureInstrumented<lf::tswd_stack::TSWDStack>(num_thread, num_thread, parameter_);
 					break;
 				}
 				default: {
@@ -197,6 +317,17 @@ namespace benchmark {
 		return true;
 	}
 
+	// The subject is not used: each scheme only reclaims nodes that are never linked.
+	bool Tester::RunReclamationBenchmark()
+	{
+		for (auto num_thread : num_threads_) {
+			MeasureReclamation<lf::EBR>(num_thread, Reclamation::kEBR);
+			MeasureReclamation<lf::HazardPointer>(num_thread, Reclamation::kHazardPointer);
+			MeasureReclamation<lf::HazardEra>(num_thread, Reclamation::kHazardEra);
+		}
+		return true;
+	}
+
 	bool Tester::RunMicroBenchmarkScalingWithDepth()
 	{
 		constexpr int32_t kMinRelaxationBound{ 320 };
@@ -207,18 +338,226 @@ namespace benchmark {
 				case Subject::k2Dd: {
 					auto width = 0 == width_ ? fixed_num_thread_ : width_;
 					auto depth = rb / (width - 1);
-					lf::twodd::TwoDd subject{ width, fixed_num_thread_, depth };
-					Measure(MicrobenchmarkFunc, rb, subject);
+					MeasureInstrumented<lf::twodd::TwoDd>(rb, width, fixed_num_thread_, depth);
 					break;
 				}
 				case Subject::kTSWD: {
 					auto depth = rb / (fixed_num_thread_ - 1) - 1;
-					lf::tswd::TSWD subject{ fixed_num_thread_, depth };
-					Measure(MicrobenchmarkFunc, rb, subject);
+					MeasureTSWD(rb, fixed_num_thread_, depth);
+					break;
+				}
+				case Subject::kTSWDMP: {
+					auto width = 0 == width_ ? fixed_num_thread_ : width_;
+					auto depth = rb / (width - 1) - 1;
+					MeasureInstrumented<lf::tswd_mp::TSWDMP>(rb, width, fixed_num_thread_, depth);
+					break;
+				}
+				case Subject::kTSWDPQ: {
+					auto depth = rb / (fixed_num_thread_ - 1);
+					MeasureInstrumented<lf::tswd_pq::TSWDPQ>(rb, fixed_num_thread_, depth);
+					break;
+				}
+				case Subject::kTSWDStack: {
+					auto depth = rb / (fixed_num_thread_ - 1) - 1;
+					MeasureInstrumented<lf::tswd_stack::TSWDStack>(rb, fixed_num_thread_, depth);
+					break;
+				}
+				default: {
+					compat::Print("[Error] Invalid subject. 'Scaling with depth' mode is only for 2Dd, TSWD, TSWD-MP, TSWD-PQ or TSWD-stack.\n\n");
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool Tester::RunMicroBenchmarkScalingWithPayload()
+	{
+		return RunMicroBenchmarkWithPayload<4>()
+			and RunMicroBenchmarkWithPayload<8>()
+			and RunMicroBenchmarkWithPayload<16>()
+			and RunMicroBenchmarkWithPayload<32>()
+			and RunMicroBenchmarkWithPayload<64>()
+			and RunMicroBenchmarkWithPayload<128>()
+			and RunMicroBenchmarkWithPayload<256>();
+	}
+
+	template<size_t kSize>
+	bool Tester::RunMicroBenchmarkWithPayload()
+	{
+		using PayloadT = Payload<kSize>;
+
+		switch (subject_) {
+			case Subject::kTSCAS: {
+				lf::ts_cas::TSCAS<PayloadT> subject{ fixed_num_thread_, parameter_ };
+				Measure(MicrobenchmarkFunc, kSize, subject);
+				break;
+			}
+			case Subject::kTSStutter: {
+				lf::ts_stutter::TSStutter<PayloadT> subject{ fixed_num_thread_ };
+				Measure(MicrobenchmarkFunc, kSize, subject);
+				break;
+			}
+			case Subject::kTSAtomic: {
+				lf::ts_atomic::TSAtomic<PayloadT> subject{ fixed_num_thread_ };
+				Measure(MicrobenchmarkFunc, kSize, subject);
+				break;
+			}
+			case Subject::kTSInterval: {
+				lf::ts_interval::TSInterval<PayloadT> subject{ fixed_num_thread_, parameter_ };
+				Measure(MicrobenchmarkFunc, kSize, subject);
+				break;
+			}
+			case Subject::kCBO: {
+				auto width = 0 == width_ ? fixed_num_thread_ : width_;
+				MeasureInstrumented<lf::cbo::CBO, PayloadT>(kSize, width, fixed_num_thread_, parameter_);
+				break;
+			}
+			case Subject::k2Dd: {
+				auto width = 0 == width_ ? fixed_num_thread_ : width_;
+				MeasureInstrumented<lf::twodd::TwoDd, PayloadT>(kSize, width, fixed_num_thread_, parameter_);
+				break;
+			}
+			case Subject::kTSWD: {
+				MeasureTSWD<PayloadT>(kSize, fixed_num_thread_, parameter_);
+				break;
+			}
+			case Subject::kTSWDMP: {
+				auto width = 0 == width_ ? fixed_num_thread_ : width_;
+				MeasureInstrumented<lf::tswd_mp::TSWDMP, PayloadT>(kSize, width, fixed_num_thread_, parameter_);
+				break;
+			}
+			case Subject::kTSWDStack: {
+				MeasureInstrumented<lf::tswd_stack::TSWDStack, PayloadT>(kSize, fixed_num_thread_, parameter_);
+				break;
+			}
+			default: {
+				compat::Print("[Error] Invalid subject.\n\n");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// In NUMA mode, measures socket-local and interleaved placements one after the other.
+	template<class T, class Instrumentation>
+	void Tester::MeasureTSWD(int32_t key, int num_thread, int depth)
+	{
+		if constexpr (std::same_as<NullRelaxationDistanceManager, Instrumentation>) {
+			if (Mode::kRelaxation == mode_) {
+				MeasureTSWD<T, RelaxationDistanceManager>(key, num_thread, depth);
+				return;
+			}
+			if (Mode::kInstrumentation == mode_) {
+				is_instrumented_ = true;
+				MeasureTSWD<T, RelaxationDistanceManager>(key, num_thread, depth);
+				is_instrumented_ = false;
+			}
+		}
+
+		if (Mode::kStall == mode_) {
+			auto capacity = static_cast<size_t>(capacity_);
+			reclamation_ = Reclamation::kEBR;
+			{
+				lf::tswd::TSWD<T, lf::EBR> subject{ num_thread, depth, capacity };
+				Measure(MicrobenchmarkFunc, key, subject);
+			}
+			reclamation_ = Reclamation::kHazardPointer;
+			{
+				lf::tswd::TSWD<T, lf::HazardPointer> subject{ num_thread, depth, capacity };
+				Measure(MicrobenchmarkFunc, key, subject);
+			}
+			reclamation_ = Reclamation::kHazardEra;
+			{
+				lf::tswd::TSWD<T, lf::HazardEra> subject{ num_thread, depth, capacity };
+				Measure(MicrobenchmarkFunc, key, subject);
+			}
+			reclamation_ = Reclamation::kNone;
+			return;
+		}
+
+		if (Mode::kHandle == mode_) {
+			auto capacity = static_cast<size_t>(capacity_);
+			{
+				lf::tswd::TSWD<T> subject{ num_thread, depth, capacity };
+				Measure(MicrobenchmarkFunc, key, subject);
+			}
+			uses_handle_ = true;
+			{
+				lf::tswd::TSWD<T> subject{ num_thread, depth, capacity };
+				Measure(HandleBenchmarkFunc, key, subject);
+			}
+			uses_handle_ = false;
+			return;
+		}
+
+		if (Mode::kCapacity == mode_) {
+			auto enq_rate = enq_rate_;
+			for (auto rate : { 50.0f, 70.0f }) {
+				enq_rate_ = rate;
+				for (auto is_bounded : { false, true }) {
+					is_bounded_ = is_bounded;
+					lf::tswd::TSWD<T> subject{ num_thread, depth, is_bounded ? static_cast<size_t>(capacity_) : 0 };
+					Measure(MicrobenchmarkFunc, key, subject);
+				}
+			}
+			is_bounded_ = false;
+			enq_rate_ = enq_rate;
+			return;
+		}
+
+		if (not numa_) {
+			lf::tswd::TSWD<T, lf::EBR, Instrumentation> subject{ num_thread, depth, static_cast<size_t>(capacity_) };
+			if (0 != max_relaxation_bound_) {
+				subject.EnableAdaptiveDepth(max_relaxation_bound_);
+			}
+			Measure(MicrobenchmarkFunc, key, subject);
+			return;
+		}
+
+		for (auto placement : { Placement::kLocal, Placement::kInterleaved }) {
+			placement_ = placement;
+			auto nodes = topology_.GetNodes(num_thread, placement);
+			// In depth scaling, the key is the relaxation bound, whose window spans a sub-window per group.
+			auto num_group = *std::max_element(nodes.begin(), nodes.end()) + 1;
+			auto group_depth = Scaling::kDepth == scaling_ ? std::max(depth / num_group, 1) : depth;
+			lf::tswd::TSWD<T, lf::EBR, Instrumentation> subject{ num_thread, group_depth,
+				std::move(nodes), static_cast<size_t>(capacity_) };
+			if (0 != max_relaxation_bound_) {
+				subject.EnableAdaptiveDepth(max_relaxation_bound_);
+			}
+			Measure(MicrobenchmarkFunc, key, subject);
+		}
+		placement_ = Placement::kNone;
+	}
+
+	bool Tester::RunMicroBenchmarkScalingWithWidth()
+	{
+		std::vector<int> widths;
+		for (int width = 1; width < fixed_num_thread_; width *= 2) {
+			widths.push_back(width);
+		}
+		widths.push_back(fixed_num_thread_);
+
+		for (auto width : widths) {
+			switch (subject_) {
+				case Subject::kCBO: {
+					if (width < parameter_) {
+						continue;
+					}
+					MeasureInstrumented<lf::cbo::CBO>(width, width, fixed_num_thread_, parameter_);
+					break;
+				}
+				case Subject::k2Dd: {
+					MeasureInstrumented<lf::twodd::TwoDd>(width, width, fixed_num_thread_, parameter_);
+					break;
+				}
+				case Subject::kTSWDMP: {
+					MeasureInstrumented<lf::tswd_mp::TSWDMP>(width, width, fixed_num_thread_, parameter_);
 					break;
 				}
 				default: {
-					compat::Print("[Error] Invalid subject. 'Scaling with depth' mode is only for 2Dd or TSWD.\n\n");
+					compat::Print("[Error] Invalid subject. 'Scaling with width' mode is only for d-CBO, 2Dd or TSWD-MP.\n\n");
 					return false;
 				}
 			}
@@ -267,6 +606,17 @@ namespace benchmark {
 					Measure(MacrobenchmarkFunc, num_thread, subject);
 					break;
 				}
+				case Subject::kTSWDMP: {
+					auto width = 0 == width_ ? num_thread : width_;
+					lf::tswd_mp::TSWDMP subject{ width, num_thread, parameter_ };
+					Measure(MacrobenchmarkFunc, num_thread, subject);
+					break;
+				}
+				case Subject::kTSWDPQ: {
+					lf::tswd_pq::TSWDPQ subject{ num_thread, parameter_ };
+					Measure(MacrobenchmarkFunc, num_thread, subject);
+					break;
+				}
 				default: {
 					compat::Print("[Error] Invalid subject.\n");
 					return false;
@@ -298,8 +648,21 @@ namespace benchmark {
 					Measure(MacrobenchmarkFunc, rb, subject);
 					break;
 				}
+				case Subject::kTSWDMP: {
+					auto width = 0 == width_ ? fixed_num_thread_ : width_;
+					auto depth = rb / (width - 1) - 1;
+					lf::tswd_mp::TSWDMP subject{ width, fixed_num_thread_, depth };
+					Measure(MacrobenchmarkFunc, rb, subject);
+					break;
+				}
+				case Subject::kTSWDPQ: {
+					auto depth = rb / (fixed_num_thread_ - 1);
+					lf::tswd_pq::TSWDPQ subject{ fixed_num_thread_, depth };
+					Measure(MacrobenchmarkFunc, rb, subject);
+					break;
+				}
 				default: {
-					compat::Print("[Error] Invalid subject. 'Scaling with depth' mode is only for 2Dd or TSWD.\n\n");
+					compat::Print("[Error] Invalid subject. 'Scaling with depth' mode is only for 2Dd, TSWD, TSWD-MP or TSWD-PQ.\n\n");
 					return false;
 				}
 			}
@@ -309,11 +672,11 @@ namespace benchmark {
 
 	void Tester::SetSubject()
 	{
-		//kNone, kTSCAS, kTSStutter, kTSAtomic, kTSInterval, kCBO, k2Dd, kTSWD
+		//kNone, kTSCAS, kTSStutter, kTSAtomic, kTSInterval, kCBO, k2Dd, kTSWD, kTSWDMP, kTSWDPQ, kTSWDStack
 
 		compat::Print("\n--- List ---\n");
 		compat::Print("1: TS-CAS, 2: TS-stutter, 3: TS-atomic, 4: TS-interval,\n");
-		compat::Print("5: d-CBO, 6: 2Dd, 7: TSWD\n");
+		compat::Print("5: d-CBO, 6: 2Dd, 7: TSWD, 8: TSWD-MP, 9: TSWD-PQ, 10: TSWD-stack\n");
 		compat::Print("Subject: ");
 		subject_ = static_cast<Subject>(InputNumber<int>());
 	}
@@ -326,6 +689,9 @@ namespace benchmark {
 		compat::Print("      d-CBO: [parameter] = d\n");
 		compat::Print("        2Dd: [parameter] = depth\n");
 		compat::Print("       TSWD: [parameter] = depth\n");
+		compat::Print("    TSWD-MP: [parameter] = depth\n");
+		compat::Print("    TSWD-PQ: [parameter] = depth (elements per heap)\n");
+		compat::Print(" TSWD-stack: [parameter] = depth\n");
 		compat::Print("Parameter: ");
 		parameter_ = InputNumber<int>();
 	}
@@ -348,26 +714,144 @@ namespace benchmark {
 		delay_ = InputNumber<float>();
 	}
 
-	void Tester::CheckRelaxationDistance()
+	void Tester::SetAllocation()
 	{
-		checks_relaxation_distance_ ^= true;
-		if (checks_relaxation_distance_) {
-			compat::Print("Checks relaxation distance.\n");
+		if (lf::Allocation::kPool == lf::node_allocation) {
+			lf::node_allocation = lf::Allocation::kHeap;
+			compat::Print("Allocates nodes from the heap.\n");
 		} else {
-			compat::Print("Checks throughput.\n");
+			lf::node_allocation = lf::Allocation::kPool;
+			compat::Print("Allocates nodes from the per-thread node pool.\n");
 		}
 	}
 
-	void Tester::ScaleWithDepth()
+	void Tester::SetReclaiming()
 	{
-		scales_with_depth_ ^= true;
-		if (scales_with_depth_) {
-			compat::Print("Scales with depth.\n");
+		if (lf::Reclaiming::kInline == lf::ebr_reclaiming) {
+			lf::ebr_reclaiming = lf::Reclaiming::kBackground;
+			compat::Print("EBR frees retired nodes on a background thread.\n");
 		} else {
-			compat::Print("Scales with thread.\n");
+			lf::ebr_reclaiming = lf::Reclaiming::kInline;
+			compat::Print("EBR frees retired nodes on the retiring thread.\n");
 		}
 	}
 
+	void Tester::SetBoundCheck()
+	{
+		checks_bound_ = not checks_bound_;
+		if (checks_bound_) {
+			compat::Print("The relaxation distance check validates every dequeue against the relaxation bound.\n");
+		} else {
+			compat::Print("The relaxation distance check only counts the distances.\n");
+		}
+	}
+
+	void Tester::SetCapacity()
+	{
+		compat::Print("Input capacity of TSWD (0 = unbounded): ");
+		capacity_ = InputNumber<int>();
+		if (capacity_ < 0) {
+			compat::Print("[Error] Invalid capacity.\n");
+			capacity_ = 0;
+		}
+	}
+
+	void Tester::SetMaxRelaxationBound()
+	{
+		compat::Print("Input max relaxation bound of TSWD (0 = fixed depth): ");
+		max_relaxation_bound_ = InputNumber<int>();
+		if (max_relaxation_bound_ < 0) {
+			compat::Print("[Error] Invalid relaxation bound.\n");
+			max_relaxation_bound_ = 0;
+		}
+	}
+
+	void Tester::SetNuma()
+	{
+		numa_ ^= true;
+		if (numa_) {
+			compat::Print("TSWD groups partial queues per NUMA node ({} nodes found).\n", topology_.GetNumNode());
+			compat::Print("Each node advances its own sub-window of the global window.\n");
+			compat::Print("Each run is measured with socket-local and interleaved placement.\n");
+		} else {
+			compat::Print("TSWD uses a single window and threads are not pinned.\n");
+		}
+	}
+
+	void Tester::ChangeMode()
+	{
+		switch (mode_) {
+			case Mode::kThroughput: {
+				mode_ = Mode::kRelaxation;
+				break;
+			}
+			case Mode::kRelaxation: {
+				mode_ = Mode::kIdle;
+				break;
+			}
+			case Mode::kIdle: {
+				mode_ = Mode::kStall;
+				break;
+			}
+			case Mode::kStall: {
+				mode_ = Mode::kReclamation;
+				break;
+			}
+			case Mode::kReclamation: {
+				mode_ = Mode::kLatency;
+				break;
+			}
+			case Mode::kLatency: {
+				mode_ = Mode::kCacheMiss;
+				break;
+			}
+			case Mode::kCacheMiss: {
+				mode_ = Mode::kHandle;
+				break;
+			}
+			case Mode::kHandle: {
+				mode_ = Mode::kInstrumentation;
+				break;
+			}
+			case Mode::kInstrumentation: {
+				mode_ = Mode::kSampling;
+				break;
+			}
+			case Mode::kSampling: {
+				mode_ = Mode::kCapacity;
+				break;
+			}
+			default: {
+				mode_ = Mode::kThroughput;
+				break;
+			}
+		}
+		compat::Print("Checks {}.\n", GetModeName(mode_));
+	}
+
+	void Tester::ChangeScaling()
+	{
+		switch (scaling_) {
+			case Scaling::kThread: {
+				scaling_ = Scaling::kDepth;
+				break;
+			}
+			case Scaling::kDepth: {
+				scaling_ = Scaling::kPayload;
+				break;
+			}
+			case Scaling::kPayload: {
+				scaling_ = Scaling::kWidth;
+				break;
+			}
+			default: {
+				scaling_ = Scaling::kThread;
+				break;
+			}
+		}
+		compat::Print("Scales with {}.\n", GetScalingName(scaling_));
+	}
+
 	void Tester::GenerateGraph()
 	{
 		compat::Print("\n--- List ---\n");
@@ -413,12 +897,18 @@ namespace benchmark {
 	void Tester::PrintHelp() const
 	{
 		compat::Print("e: Set enqueue rate\n");
-		compat::Print("m: Toggle microbenchmark mode (throughput/relaxation)\n");
-		compat::Print("c: Toggle scaling mode (thread/depth)\n");
+		compat::Print("m: Change microbenchmark mode (throughput/relaxation/idle/stall/reclamation/latency/cache miss/handle/instrumentation/sampling/capacity)\n");
+		compat::Print("c: Change scaling mode (thread/depth/payload size/width)\n");
 		compat::Print("s: Set subject\n");
 		compat::Print("p: Set parameter\n");
 		compat::Print("w: Set width\n");
 		compat::Print("d: Set delay\n");
+		compat::Print("n: Toggle node allocation (pool/heap)\n");
+		compat::Print("u: Toggle NUMA mode for TSWD\n");
+		compat::Print("b: Set capacity of TSWD\n");
+		compat::Print("r: Set max relaxation bound for adaptive depth of TSWD\n");
+		compat::Print("f: Toggle background reclaimer thread of EBR\n");
+		compat::Print("k: Toggle relaxation bound check in relaxation mode\n");
 		compat::Print("l: Load graph\n");
 		compat::Print("g: Generate graph\n");
 		compat::Print("i: Microbenchmark\n");
@@ -440,7 +930,7 @@ namespace benchmark {
 			case Subject::kCBO: {
 				auto min_width{ width_ };
 				if (0 == width_) {
-					if (scales_with_depth_) {
+					if (Scaling::kThread != scaling_) {
 						min_width = fixed_num_thread_;
 					} else {
 						min_width = num_threads_.front();
@@ -454,14 +944,23 @@ namespace benchmark {
 				break;
 			}
 			case Subject::k2Dd: {
-				if (parameter_ <= 0 and not scales_with_depth_) {
+				if (parameter_ <= 0 and Scaling::kDepth != scaling_) {
 					compat::Print("[Error] Invalid depth.\n");
 					return false;
 				}
 				break;
 			}
-			case Subject::kTSWD: {
-				if (parameter_ <= 0 and not scales_with_depth_) {
+			case Subject::kTSWD:
+			case Subject::kTSWDMP:
+			case Subject::kTSWDStack: {
+				if (parameter_ <= 0 and Scaling::kDepth != scaling_) {
+					compat::Print("[Error] Invalid depth.\n");
+					return false;
+				}
+				break;
+			}
+			case Subject::kTSWDPQ: {
+				if (parameter_ < 0 and Scaling::kDepth != scaling_) {
 					compat::Print("[Error] Invalid depth.\n");
 					return false;
 				}
@@ -6,12 +6,25 @@
 #include <thread>
 #include <memory>
 #include <map>
+#include <atomic>
+#include <span>
+#include <optional>
+#include <numeric>
+#include <algorithm>
 #include "stopwatch.h"
 #include "graph.h"
 #include "benchmark_result.h"
 #include "microbenchmark_thread_func.h"
 #include "macrobenchmark_thread_func.h"
 #include "subject_type.h"
+#include "scaling_type.h"
+#include "mode_type.h"
+#include "payload.h"
+#include "node_pool.h"
+#include "per_thread_array.h"
+#include "topology.h"
+#include "perf_counter.h"
+#include "relaxation_distance.h"
 
 namespace benchmark {
 
@@ -51,6 +64,11 @@ namespace benchmark {
 		void Run();
 		void RunMicroBenchmark();
 		void RunMacroBenchmark();
+
+		// Dequeues that exceeded the relaxation bound over every bound check of the session.
+		uint64_t GetNumBoundViolation() const {
+			return num_bound_violation_;
+		}
 	private:
 		template<class Subject>
 		using MicrobenchmarkFuncT = void(*)(int, int, float, float, Subject&);
@@ -58,11 +76,19 @@ namespace benchmark {
 		template<class Subject>
 		using MacrobenchmarkFuncT = void(*)(int, int, Subject&, Graph&, int&);
 
+		template<class Subject>
+		using IdleBenchmarkFuncT = void(*)(int, int, float, std::atomic<int>&, Subject&);
+
 		template<class Subject>
 		using PrefillFuncT = void(*)(int, int, Subject&);
 
 		bool RunMicroBenchmarkScalingWithThread();
 		bool RunMicroBenchmarkScalingWithDepth();
+		bool RunMicroBenchmarkScalingWithPayload();
+		bool RunMicroBenchmarkScalingWithWidth();
+		bool RunReclamationBenchmark();
+		bool RunMicroBenchmarkScaling();
+		bool RunMicroBenchmarkWithReclaiming();
 		bool RunMacroBenchmarkScalingWithThread();
 		bool RunMacroBenchmarkScalingWithDepth();
 		void SetSubject();
@@ -70,8 +96,14 @@ namespace benchmark {
 		void SetEnqRate();
 		void SetWidth();
 		void SetDelay();
-		void CheckRelaxationDistance();
-		void ScaleWithDepth();
+		void SetAllocation();
+		void SetNuma();
+		void SetCapacity();
+		void SetMaxRelaxationBound();
+		void SetReclaiming();
+		void SetBoundCheck();
+		void ChangeMode();
+		void ChangeScaling();
 		void GenerateGraph();
 		void LoadGraph();
 		void PrintHelp() const;
@@ -92,36 +124,398 @@ namespace benchmark {
 
 		template<class Subject>
 		void Measure(MicrobenchmarkFuncT<Subject> thread_func, int32_t key, Subject& subject) {
+			if (Mode::kIdle == mode_) {
+				Measure(IdleBenchmarkFunc, key, subject);
+				return;
+			}
+			if (Mode::kLatency == mode_) {
+				MeasureLatency(key, subject);
+				return;
+			}
+			if constexpr (requires(const std::atomic<bool>& resume) { subject.Stall(resume); }) {
+				if (Mode::kStall == mode_) {
+					MeasureStall(key, subject);
+					return;
+				}
+			}
+
 			Stopwatch stopwatch;
-			auto num_thread = scales_with_depth_ ? fixed_num_thread_ : key;
+			auto num_thread = Scaling::kThread == scaling_ ? key : fixed_num_thread_;
 
 			results.try_emplace(key, std::vector<Result>{});
 
-			if (checks_relaxation_distance_) {
+			if (Mode::kRelaxation == mode_) {
 				subject.CheckRelaxationDistance();
+				if constexpr (requires { subject.GetRelaxationBound(); }) {
+					if (checks_bound_) {
+						subject.CheckRelaxationBound(subject.GetRelaxationBound(), GetBoundTolerance(num_thread));
+					}
+				}
 			}
 
+			num_prefilled = 0;
 			CreateThreads(Prefill, num_thread, subject);
+			auto num_prefill_allocation = subject.GetNumAllocation();
+			AllocationCounter::ResetTotal();
+			num_full_enq = 0;
 
+			if (Mode::kSampling == mode_) {
+				rank_error_sampler.Reset(num_thread, num_prefilled, kTotalNumOp / RankErrorSampler::kSamplePeriod);
+				thread_func = SampledBenchmarkFunc;
+			}
+
+			std::optional<CacheMissCounter> cache_miss_counter;
+			if (Mode::kCacheMiss == mode_) {
+				cache_miss_counter.emplace();
+				cache_miss_counter->Start();
+			}
 			stopwatch.Start();
-			CreateThreads(MicrobenchmarkFunc, num_thread, subject);
+			CreateThreads(thread_func, num_thread, subject);
 			auto elapsed_sec = stopwatch.GetDuration();
-			auto [num_element, sum_rd, max_rd] = subject.GetRelaxationDistance();
-
-			results[key].emplace_back(elapsed_sec, num_element, sum_rd, max_rd);
+			CacheMissCounter::Count cache_miss{};
+			if (cache_miss_counter.has_value()) {
+				cache_miss = cache_miss_counter->Stop();
+			}
+			auto num_allocation = subject.GetNumAllocation() - num_prefill_allocation;
+			auto num_heap_allocation = AllocationCounter::ResetTotal();
+			auto relaxation_distance = Mode::kSampling == mode_
+				? rank_error_sampler.GetRelaxationDistance() : subject.GetRelaxationDistance();
+			auto num_element = relaxation_distance.total.GetNumElement();
+			auto sum_rd = relaxation_distance.total.GetSum();
+			auto max_rd = relaxation_distance.total.GetMax();
+
+			auto& result = results[key].emplace_back(elapsed_sec, num_element, sum_rd, max_rd,
+				num_allocation, num_heap_allocation);
+			result.placement = placement_;
+			result.num_cache_miss = cache_miss.num_cache_miss;
+			result.num_l1d_miss = cache_miss.num_l1d_miss;
+			result.uses_handle = uses_handle_;
+			result.is_instrumented = is_instrumented_;
+			result.is_bounded = is_bounded_;
+			result.enq_rate = enq_rate_;
+			result.relaxation_distance = std::move(relaxation_distance);
 
 			compat::Print("     threads: {}\n", num_thread);
-			if (scales_with_depth_) {
+			if (Placement::kNone != placement_) {
+				compat::Print("   placement: {}\n", GetPlacementName(placement_));
+			}
+			if (Mode::kHandle == mode_) {
+				compat::Print("      access: {}\n", uses_handle_ ? "handle" : "thread ID");
+			}
+			if (Mode::kInstrumentation == mode_) {
+				compat::Print("instrumented: {}\n", is_instrumented_ ? "runtime check" : "compiled out");
+			}
+			if (Mode::kCapacity == mode_) {
+				compat::Print("    enq rate: {}%\n", enq_rate_);
+				compat::Print("    capacity: {}\n", is_bounded_ ? capacity_ : 0);
+			}
+			if (Scaling::kDepth == scaling_) {
 				compat::Print("k-relaxation: {}\n", key);
+			} else if (Scaling::kPayload == scaling_) {
+				compat::Print("     payload: {} B\n", key);
+			} else if (Scaling::kWidth == scaling_) {
+				compat::Print("       width: {}\n", key);
 			}
-			if (checks_relaxation_distance_) {
+			if (Mode::kRelaxation == mode_) {
 				compat::Print("    avg dist: {:.2f}\n", static_cast<double>(sum_rd) / num_element);
 				compat::Print("    max dist: {}\n", max_rd);
+				PrintRelaxationPercentiles(result.relaxation_distance.total);
+				if (result.relaxation_distance.bound.has_value()) {
+					PrintBoundViolations(result.relaxation_distance);
+				}
 			} else {
 				compat::Print("elapsed time: {:.2f} sec\n", elapsed_sec);
 				auto throughput = kTotalNumOp / elapsed_sec / 1e6;
 				compat::Print("  throughput: {:.2f} MOp/s\n", throughput);
+				compat::Print("node allocs/op: {:.4f}\n", static_cast<double>(num_allocation) / kTotalNumOp);
+				if constexpr (AllocationCounter::kIsEnabled) {
+					compat::Print("heap allocs/op: {:.4f}\n", static_cast<double>(num_heap_allocation) / kTotalNumOp);
+				}
+				if (0 != capacity_ and (Mode::kCapacity != mode_ or is_bounded_) and requires { subject.TryEnq(0); }) {
+					compat::Print(" full enqs/op: {:.4f}\n", static_cast<double>(num_full_enq) / kTotalNumOp);
+				}
+				if (Mode::kSampling == mode_) {
+					compat::Print("sampled dist: avg {:.2f}, max {} over {} samples\n",
+						static_cast<double>(sum_rd) / num_element, max_rd, num_element);
+					PrintRelaxationPercentiles(result.relaxation_distance.total);
+				}
+				if constexpr (requires { subject.GetPeakNumRetired(); }) {
+					PrintPeakNumRetired(subject.GetPeakNumRetired());
+				}
+				if (cache_miss_counter.has_value() and cache_miss_counter->IsValid()) {
+					compat::Print("cache misses/op: {:.3f}\n", static_cast<double>(cache_miss.num_cache_miss) / kTotalNumOp);
+					compat::Print("  L1D misses/op: {:.3f}\n", static_cast<double>(cache_miss.num_l1d_miss) / kTotalNumOp);
+				}
+			}
+			if constexpr (requires { subject.GetDepthTrajectory(); }) {
+				PrintDepthTrajectory(subject.GetDepthTrajectory());
+			}
+			compat::Print("\n");
+		}
+
+		void PrintRelaxationPercentiles(const RelaxationDistanceHistogram& histogram) const {
+			auto percentiles = histogram.GetPercentiles();
+			compat::Print(" percentiles:");
+			for (size_t i = 0; i < kRelaxationPercentiles.size(); ++i) {
+				compat::Print(" p{}: {}{}", kRelaxationPercentiles[i], percentiles[i],
+					i + 1 < kRelaxationPercentiles.size() ? "," : "\n");
+			}
+		}
+
+		/* Stamps are taken next to the linearizing steps rather than at them, so every other thread
+		may have one operation in flight on each side of a dequeue. */
+		static uint64_t GetBoundTolerance(int num_thread) {
+			return 2 * static_cast<uint64_t>(num_thread - 1);
+		}
+
+		/* Dequeues over the claimed bound but within the tolerance pass, but are reported apart.
+		Lists the first violations with the window from the oldest element present to the dequeued one. */
+		void PrintBoundViolations(const RelaxationDistanceReport& report) {
+			auto bound = *report.bound;
+			if (0 == report.num_violation) {
+				if (0 == report.num_within_tolerance) {
+					compat::Print(" bound check: passed, every dist within the claimed {}\n", bound);
+				} else {
+					compat::Print(" bound check: passed only with the tolerance, {} dequeues over the claimed {} within +{} in flight\n",
+						report.num_within_tolerance, bound, report.tolerance);
+				}
+				return;
+			}
+
+			num_bound_violation_ += report.num_violation;
+			compat::Print("[Error] {} of {} dequeues exceed the relaxation bound of {} + {} in flight ({} more within the tolerance).\n",
+				report.num_violation, report.total.GetNumElement(), bound, report.tolerance, report.num_within_tolerance);
+			for (const auto& violation : report.violations) {
+				if (violation.is_by_priority) {
+					compat::Print("  dequeue #{} by thread {} from queue {}: dist {}, window priority {} to {}, at {:.3f} ms\n",
+						violation.deq_index, violation.thread, violation.queue, violation.rd,
+						violation.first, violation.last, violation.deq_ns / 1e6);
+				} else {
+					compat::Print("  dequeue #{} by thread {} from queue {}: dist {}, window enq #{} to #{}, {:.3f} to {:.3f} ms\n",
+						violation.deq_index, violation.thread, violation.queue, violation.rd,
+						violation.first, violation.last, violation.first_ns / 1e6, violation.deq_ns / 1e6);
+				}
+			}
+			if (report.num_violation > report.violations.size()) {
+				compat::Print("  ... and {} more\n", report.num_violation - report.violations.size());
+			}
+		}
+
+		// Summarizes the longest retired list of each thread.
+		void PrintPeakNumRetired(const std::vector<uint64_t>& peaks) const {
+			auto sum = std::accumulate(peaks.begin(), peaks.end(), uint64_t{});
+			compat::Print("retired list: avg peak {:.1f}, max peak {} nodes per thread\n",
+				static_cast<double>(sum) / peaks.size(), std::ranges::max(peaks));
+		}
+
+		// Prints the depths set by the adaptive controller as "sec:depth", eight per line.
+		template<class Sample>
+		void PrintDepthTrajectory(std::span<const Sample> trajectory) const {
+			if (trajectory.empty()) {
+				return;
+			}
+			compat::Print("depth trajectory:");
+			for (size_t i = 0; i < trajectory.size(); ++i) {
+				if (i > 0 and 0 == i % 8) {
+					compat::Print("\n                 ");
+				}
+				compat::Print(" {:.3f}s:{}", trajectory[i].sec, trajectory[i].depth);
+			}
+			compat::Print("\n");
+		}
+
+		/* One thread holds an operation open for the whole run while the others run the microbenchmark.
+		The unreclaimed nodes are sampled every millisecond and the peak is reported. */
+		template<class Subject>
+		void MeasureStall(int32_t key, Subject& subject) {
+			Stopwatch stopwatch;
+			auto num_thread = Scaling::kThread == scaling_ ? key : fixed_num_thread_;
+			auto num_worker = num_thread - 1;
+			std::atomic<bool> resume{};
+			std::atomic<int> num_running{ num_worker };
+
+			results.try_emplace(key, std::vector<Result>{});
+
+			CreateThreads(Prefill, num_thread, subject);
+
+			std::thread stalled{ [&] {
+				MyThreadID::Set(num_worker);
+				subject.Stall(resume);
+				} };
+
+			std::vector<std::thread> threads;
+			threads.reserve(num_worker);
+			stopwatch.Start();
+			for (int thread_id = 0; thread_id < num_worker; ++thread_id) {
+				threads.emplace_back([&, thread_id] {
+					MicrobenchmarkFunc(thread_id, num_worker, enq_rate_, delay_, subject);
+					num_running.fetch_sub(1);
+					});
+				topology_.Pin(threads.back(), thread_id, placement_);
+			}
+
+			uint64_t peak_unreclaimed{};
+			while (num_running.load() > 0) {
+				peak_unreclaimed = std::max(peak_unreclaimed, subject.GetNumUnreclaimed());
+				std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+			}
+			for (auto& t : threads) {
+				t.join();
+			}
+			auto elapsed_sec = stopwatch.GetDuration();
+			peak_unreclaimed = std::max(peak_unreclaimed, subject.GetNumUnreclaimed());
+
+			resume.store(true, std::memory_order_release);
+			stalled.join();
+
+			Result result{};
+			result.elapsed_sec = elapsed_sec;
+			result.reclamation = reclamation_;
+			result.peak_unreclaimed = peak_unreclaimed;
+			results[key].push_back(result);
+
+			compat::Print("     threads: {} (1 stalled)\n", num_thread);
+			compat::Print(" reclamation: {}\n", GetReclamationName(reclamation_));
+			if (Scaling::kDepth == scaling_) {
+				compat::Print("k-relaxation: {}\n", key);
+			} else if (Scaling::kPayload == scaling_) {
+				compat::Print("     payload: {} B\n", key);
+			}
+			compat::Print("elapsed time: {:.2f} sec\n", elapsed_sec);
+			compat::Print("  throughput: {:.2f} MOp/s\n", kTotalNumOp / elapsed_sec / 1e6);
+			compat::Print("peak unreclaimed: {} nodes\n", peak_unreclaimed);
+			compat::Print("\n");
+		}
+
+		// Records the latency of every dequeue and reports its percentiles.
+		template<class Subject>
+		void MeasureLatency(int32_t key, Subject& subject) {
+			Stopwatch stopwatch;
+			auto num_thread = Scaling::kThread == scaling_ ? key : fixed_num_thread_;
+			lf::PerThreadArray<std::vector<uint32_t>> latencies{ num_thread, 1 };
+
+			results.try_emplace(key, std::vector<Result>{});
+
+			CreateThreads(Prefill, num_thread, subject);
+
+			std::vector<std::thread> threads;
+			threads.reserve(num_thread);
+			stopwatch.Start();
+			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
+				threads.emplace_back(LatencyBenchmarkFunc<Subject>, thread_id, num_thread, enq_rate_, delay_,
+					std::ref(subject), std::ref(latencies[thread_id].front()));
+				topology_.Pin(threads.back(), thread_id, placement_);
+			}
+			for (auto& t : threads) {
+				t.join();
+			}
+			auto elapsed_sec = stopwatch.GetDuration();
+
+			std::vector<uint32_t> merged;
+			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
+				const auto& latency = latencies[thread_id].front();
+				merged.insert(merged.end(), latency.begin(), latency.end());
+			}
+
+			Result result{};
+			result.elapsed_sec = elapsed_sec;
+			result.reclamation = reclamation_;
+			if (not merged.empty()) {
+				for (size_t i = 0; i < kLatencyPercentiles.size(); ++i) {
+					auto nth = merged.begin() + std::min(merged.size() - 1,
+						static_cast<size_t>(merged.size() * kLatencyPercentiles[i] / 100.0));
+					std::nth_element(merged.begin(), nth, merged.end());
+					result.latency_ns[i] = *nth;
+				}
+				result.latency_ns.back() = std::ranges::max(merged);
+			}
+			results[key].push_back(result);
+
+			compat::Print("     threads: {}\n", num_thread);
+			compat::Print(" reclamation: {}\n", GetReclamationName(reclamation_));
+			if (Scaling::kDepth == scaling_) {
+				compat::Print("k-relaxation: {}\n", key);
+			} else if (Scaling::kPayload == scaling_) {
+				compat::Print("     payload: {} B\n", key);
+			} else if (Scaling::kWidth == scaling_) {
+				compat::Print("       width: {}\n", key);
 			}
+			compat::Print("elapsed time: {:.2f} sec\n", elapsed_sec);
+			compat::Print("  throughput: {:.2f} MOp/s\n", kTotalNumOp / elapsed_sec / 1e6);
+			compat::Print(" deq latency:");
+			for (size_t i = 0; i < kLatencyPercentiles.size(); ++i) {
+				compat::Print(" p{}: {} ns,", kLatencyPercentiles[i], result.latency_ns[i]);
+			}
+			compat::Print(" max: {} ns\n", result.latency_ns.back());
+			compat::Print("\n");
+		}
+
+		// Measures a reclamation scheme alone, so that its cost per operation is compared across thread counts.
+		template<template<class> class Reclaimer>
+		void MeasureReclamation(int num_thread, Reclamation reclamation) {
+			lf::NodePool<ReclaimedNode> pool{ num_thread };
+			Reclaimer<ReclaimedNode> reclaimer{ num_thread, pool };
+			ReclaimedNode* volatile shared{};
+			Stopwatch stopwatch;
+
+			results.try_emplace(num_thread, std::vector<Result>{});
+
+			std::vector<std::thread> threads;
+			threads.reserve(num_thread);
+			stopwatch.Start();
+			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
+				threads.emplace_back(ReclamationBenchmarkFunc<Reclaimer<ReclaimedNode>, lf::NodePool<ReclaimedNode>>,
+					thread_id, num_thread, std::ref(reclaimer), std::ref(pool), std::ref(shared));
+				topology_.Pin(threads.back(), thread_id, placement_);
+			}
+			for (auto& t : threads) {
+				t.join();
+			}
+			auto elapsed_sec = stopwatch.GetDuration();
+
+			Result result{};
+			result.elapsed_sec = elapsed_sec;
+			result.reclamation = reclamation;
+			results[num_thread].push_back(result);
+
+			compat::Print("     threads: {}\n", num_thread);
+			compat::Print(" reclamation: {}\n", GetReclamationName(reclamation));
+			compat::Print("elapsed time: {:.2f} sec\n", elapsed_sec);
+			compat::Print("per-thread time: {:.1f} ns/op\n", elapsed_sec * num_thread / kTotalNumOp * 1e9);
+			compat::Print("\n");
+		}
+
+		template<class Subject>
+		void Measure(IdleBenchmarkFuncT<Subject> thread_func, int32_t key, Subject& subject) {
+			Stopwatch stopwatch;
+			CpuStopwatch cpu_stopwatch;
+			auto num_thread = Scaling::kThread == scaling_ ? key : fixed_num_thread_;
+			std::atomic<int> num_active_producer{ num_thread / 2 };
+
+			results.try_emplace(key, std::vector<Result>{});
+
+			stopwatch.Start();
+			cpu_stopwatch.Start();
+			CreateThreads(IdleBenchmarkFunc, num_thread, subject, num_active_producer);
+			auto cpu_sec = cpu_stopwatch.GetDuration();
+			auto elapsed_sec = stopwatch.GetDuration();
+
+			results[key].emplace_back(elapsed_sec, cpu_sec).placement = placement_;
+
+			compat::Print("     threads: {}\n", num_thread);
+			if (Placement::kNone != placement_) {
+				compat::Print("   placement: {}\n", GetPlacementName(placement_));
+			}
+			if (Scaling::kDepth == scaling_) {
+				compat::Print("k-relaxation: {}\n", key);
+			} else if (Scaling::kPayload == scaling_) {
+				compat::Print("     payload: {} B\n", key);
+			} else if (Scaling::kWidth == scaling_) {
+				compat::Print("       width: {}\n", key);
+			}
+			compat::Print("elapsed time: {:.2f} sec\n", elapsed_sec);
+			compat::Print("    cpu time: {:.2f} sec\n", cpu_sec);
+			compat::Print("  busy cores: {:.2f} / {}\n", cpu_sec / elapsed_sec, num_thread);
 			compat::Print("\n");
 		}
 
@@ -130,19 +524,25 @@ namespace benchmark {
 			graph_->Reset();
 
 			Stopwatch stopwatch;
-			auto num_thread = scales_with_depth_ ? fixed_num_thread_ : key;
-			std::vector<int32_t> distances(num_thread, std::numeric_limits<int>::max());
+			auto num_thread = Scaling::kThread == scaling_ ? key : fixed_num_thread_;
+			lf::PerThreadArray<int32_t> distances{ num_thread, 1 };
+			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
+				distances[thread_id].front() = std::numeric_limits<int>::max();
+			}
 			
 			results.try_emplace(key, std::vector<Result>{});
 
 			stopwatch.Start();
 			CreateThreads(MacrobenchmarkFunc, num_thread, subject, distances);
 			
-			auto distance = *std::min_element(distances.begin(), distances.end());
+			auto distance = std::numeric_limits<int>::max();
+			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
+				distance = std::min(distance, distances[thread_id].front());
+			}
 			auto elapsed_sec = stopwatch.GetDuration();
 
 			compat::Print("     threads: {}\n", num_thread);
-			if (scales_with_depth_) {
+			if (Scaling::kDepth == scaling_) {
 				compat::Print("k-relaxation: {}\n", key);
 			}
 			compat::Print("elapsed time: {:.2f} sec\n", elapsed_sec);
@@ -159,7 +559,8 @@ namespace benchmark {
 			
 			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
 				threads.emplace_back(thread_func, thread_id, num_thread, enq_rate_,
-					checks_relaxation_distance_ ? 0.0f : delay_, std::ref(subject));
+					Mode::kRelaxation == mode_ ? 0.0f : delay_, std::ref(subject));
+				topology_.Pin(threads.back(), thread_id, placement_);
 			}
 
 			for (auto& t : threads) {
@@ -169,13 +570,30 @@ namespace benchmark {
 
 		template<class Subject>
 		void CreateThreads(MacrobenchmarkFuncT<Subject> thread_func,
-			int num_thread, Subject& subject, std::vector<int32_t>& distances) {
+			int num_thread, Subject& subject, lf::PerThreadArray<int32_t>& distances) {
 			std::vector<std::thread> threads;
 			threads.reserve(num_thread);
 
 			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
 				threads.emplace_back(thread_func, thread_id, num_thread,
-					std::ref(subject), std::ref(*graph_), std::ref(distances[thread_id]));
+					std::ref(subject), std::ref(*graph_), std::ref(distances[thread_id].front()));
+			}
+
+			for (auto& t : threads) {
+				t.join();
+			}
+		}
+
+		template<class Subject>
+		void CreateThreads(IdleBenchmarkFuncT<Subject> thread_func, int num_thread,
+			Subject& subject, std::atomic<int>& num_active_producer) {
+			std::vector<std::thread> threads;
+			threads.reserve(num_thread);
+
+			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
+				threads.emplace_back(thread_func, thread_id, num_thread, delay_,
+					std::ref(num_active_producer), std::ref(subject));
+				topology_.Pin(threads.back(), thread_id, placement_);
 			}
 
 			for (auto& t : threads) {
@@ -190,6 +608,7 @@ namespace benchmark {
 
 			for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
 				threads.emplace_back(thread_func, thread_id, num_thread, std::ref(subject));
+				topology_.Pin(threads.back(), thread_id, placement_);
 			}
 
 			for (auto& t : threads) {
@@ -197,6 +616,28 @@ namespace benchmark {
 			}
 		}
 
+		/* The relaxation distance is only instrumented in relaxation mode,
+		and in instrumentation mode the subject is measured with and without it. */
+		template<template<class, class> class Subject, class T = int, class... Args>
+		void MeasureInstrumented(int32_t key, const Args&... args) {
+			if (Mode::kRelaxation == mode_ or Mode::kInstrumentation == mode_) {
+				is_instrumented_ = true;
+				Subject<T, RelaxationDistanceManager> subject{ args... };
+				Measure(MicrobenchmarkFunc, key, subject);
+				is_instrumented_ = false;
+			}
+			if (Mode::kRelaxation != mode_) {
+				Subject<T, NullRelaxationDistanceManager> subject{ args... };
+				Measure(MicrobenchmarkFunc, key, subject);
+			}
+		}
+
+		template<class T = int, class Instrumentation = NullRelaxationDistanceManager>
+		void MeasureTSWD(int32_t key, int num_thread, int depth);
+
+		template<size_t kSize>
+		bool RunMicroBenchmarkWithPayload();
+
 		bool HasValidParameter() const;
 
 		std::unique_ptr<Graph> graph_{};
@@ -204,8 +645,19 @@ namespace benchmark {
 		int width_{};
 		Subject subject_{};
 		ResultMap results;
-		bool checks_relaxation_distance_{};
-		bool scales_with_depth_{};
+		Mode mode_{};
+		Topology topology_;
+		bool numa_{};
+		int capacity_{};
+		int max_relaxation_bound_{};
+		Placement placement_{};
+		Reclamation reclamation_{};
+		bool uses_handle_{};
+		bool is_instrumented_{};
+		bool is_bounded_{};
+		bool checks_bound_{};
+		uint64_t num_bound_violation_{};
+		Scaling scaling_{};
 		float enq_rate_{ 50.0f };
 		float delay_{ 1.2f };
 
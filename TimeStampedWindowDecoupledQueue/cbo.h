@@ -7,35 +7,42 @@
 #include <numeric>
 #include <algorithm>
 #include <chrono>
+#include <concepts>
 #include "random.h"
 #include "ebr.h"
+#include "per_thread_array.h"
 #include "relaxation_distance.h"
 
 namespace lf::cbo {
+	template<class T>
 	struct Node {
 		Node() = default;
-		Node(int v) : v{ v } {}
+		Node(T v) : v{ std::move(v) } {}
 
 		Node* volatile next{};
 		uint64_t retire_epoch{};
 		uint64_t stamp{};
-		int v{};
+		T v{};
 	};
 
+	template<class T>
 	class PartialQueue {
 	public:
-		PartialQueue() : tail_{ new Node }, head_{ tail_ } {}
+		using Node = cbo::Node<T>;
+
+		PartialQueue(NodePool<Node>& pool) : pool_{ pool }, tail_{ pool.New() }, head_{ tail_ } {}
 		~PartialQueue() {
 			while (nullptr != head_->next) {
 				Node* t = head_;
 				head_ = head_->next;
-				delete t;
+				pool_.Destroy(t);
 			}
-			delete head_;
+			pool_.Destroy(head_);
 		}
 
-		void Enq(int v, benchmark::RelaxationDistanceManager& rdm) {
-			auto node = new Node{ v };
+		template<class Instrumentation>
+		void Enq(T v, Instrumentation& rdm) {
+			auto node = pool_.New(std::move(v));
 
 			while (true) {
 				auto loc_tail = tail_;
@@ -47,21 +54,20 @@ namespace lf::cbo {
 
 				if (nullptr == next) {
 					node->stamp = loc_tail->stamp + 1;
-					rdm.LockEnq();
+					auto stamp = rdm.Stamp();
 					if (true == CAS(loc_tail->next, nullptr, node)) {
-						rdm.Enq(node);
-						rdm.UnlockEnq();
+						rdm.Enq(node, stamp);
 						CAS(tail_, loc_tail, node);
 						return;
 					}
-					rdm.UnlockEnq();
 				} else {
 					CAS(tail_, loc_tail, next);
 				}
 			}
 		}
 
-		std::optional<int> TryDeq(EBR<Node>& ebr, benchmark::RelaxationDistanceManager& rdm) {
+		template<class Instrumentation>
+		std::optional<T> TryDeq(EBR<Node>& ebr, Instrumentation& rdm) {
 			while (true) {
 				auto loc_head = head_;
 				auto loc_tail = tail_;
@@ -76,15 +82,13 @@ namespace lf::cbo {
 					CAS(tail_, loc_tail, first);
 					continue;
 				}
-				auto value = first->v;
-				
-				rdm.LockDeq();
 				if (false == CAS(head_, loc_head, first)) {
-					rdm.UnlockDeq();
 					continue;
 				}
-				rdm.Deq(first);
-				rdm.UnlockDeq();
+				rdm.Deq(first, this);
+
+				// Only the winner of the CAS owns the payload, so it can be moved out.
+				std::optional<T> value{ std::move(first->v) };
 				ebr.Retire(loc_head);
 				return value;
 			}
@@ -104,16 +108,27 @@ namespace lf::cbo {
 				&expected, desired);
 		}
 
+		NodePool<Node>& pool_;
 		alignas(std::hardware_destructive_interference_size) Node* volatile tail_;
 		alignas(std::hardware_destructive_interference_size) Node* volatile head_;
 	};
 
+	template<class T = int, class Instrumentation = benchmark::NullRelaxationDistanceManager>
+		requires std::movable<T> and std::default_initializable<T>
 	class CBO {
 	public:
-		CBO(int num_queue, int num_thread, int d) : d_{ d }, indices_(num_thread)
-			, queues_(num_queue), ebr_{ num_thread } {
-			for (auto& indices : indices_) {
-				indices.resize(num_queue);
+		using Node = cbo::Node<T>;
+
+		CBO(int num_queue, int num_thread, int d) : d_{ d }
+			, indices_{ num_thread, static_cast<size_t>(num_queue) }
+			, pool_{ num_thread }, ebr_{ num_thread, pool_ }
+			, versions_{ num_thread, static_cast<size_t>(num_queue) } {
+			queues_.reserve(num_queue);
+			for (int i = 0; i < num_queue; ++i) {
+				queues_.emplace_back(pool_);
+			}
+			for (int id = 0; id < num_thread; ++id) {
+				auto indices = indices_[id];
 				std::iota(indices.begin(), indices.end(), 0);
 			}
 		}
@@ -126,14 +141,21 @@ namespace lf::cbo {
 			return rdm_.GetRelaxationDistance();
 		}
 
-		void Enq(int v) {
+		auto GetNumAllocation() const {
+			return pool_.GetNumAllocation();
+		}
+
+		auto GetPeakNumRetired() const {
+			return ebr_.GetPeakNumRetired();
+		}
+
+		void Enq(T v) {
 			ebr_.StartOp();
-			queues_[GetEnqueuerIndex()].Enq(v, rdm_);
+			queues_[GetEnqueuerIndex()].Enq(std::move(v), rdm_);
 			ebr_.EndOp();
 		}
 
-		std::optional<int> Deq() {
-			std::vector<Node*> old_tails(queues_.size());
+		std::optional<T> Deq() {
 			ebr_.StartOp();
 
 			auto optimal = GetDequeuerIndex();
@@ -149,7 +171,7 @@ namespace lf::cbo {
 	private:
 		size_t GetEnqueuerIndex() {
 			ShuffleIndex();
-			auto& indices = indices_[MyThreadID::Get()];
+			auto indices = indices_[MyThreadID::Get()];
 			
 			return *std::min_element(indices.begin(), indices.begin() + d_, [this](size_t a, size_t b) {
 				return queues_[a].GetTail()->stamp < queues_[b].GetTail()->stamp;
@@ -158,15 +180,15 @@ namespace lf::cbo {
 
 		size_t GetDequeuerIndex() {
 			ShuffleIndex();
-			auto& indices = indices_[MyThreadID::Get()];
+			auto indices = indices_[MyThreadID::Get()];
 
 			return *std::min_element(indices.begin(), indices.begin() + d_, [this](size_t a, size_t b) {
 				return queues_[a].GetHead()->stamp < queues_[b].GetHead()->stamp;
 				});
 		}
 
-		std::optional<int> DoubleCollect(size_t start) {
-			std::vector<Node*> versions(queues_.size());
+		std::optional<T> DoubleCollect(size_t start) {
+			auto versions = versions_[MyThreadID::Get()];
 			while (true) {
 				for (size_t i = 0; i < queues_.size(); ++i) {
 					auto id = (start + i) % queues_.size();
@@ -194,7 +216,7 @@ namespace lf::cbo {
 		}
 
 		void ShuffleIndex() {
-			auto& indices = indices_[MyThreadID::Get()];
+			auto indices = indices_[MyThreadID::Get()];
 			for (int i = 0; i < d_; ++i) {
 				auto r = Random::Get(i, indices.size() - 1);
 				std::swap(indices[i], indices[r]);
@@ -202,10 +224,12 @@ namespace lf::cbo {
 		}
 
 		int d_;
-		std::vector<std::vector<size_t>> indices_;
-		std::vector<PartialQueue> queues_;
+		PerThreadArray<size_t> indices_;
+		NodePool<Node> pool_;
+		std::vector<PartialQueue<T>> queues_;
 		EBR<Node> ebr_;
-		benchmark::RelaxationDistanceManager rdm_;
+		PerThreadArray<Node*> versions_;
+		[[no_unique_address]] Instrumentation rdm_;
 	};
 }
 
@@ -1,18 +1,34 @@
 #ifndef EBR_H
 #define EBR_H
 
-#include <queue>
+#include <new>
 #include <vector>
 #include <atomic>
+#include <mutex>
 #include <limits>
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <chrono>
+#include <cstdint>
 #include "my_thread_id.h"
+#include "node_pool.h"
 
 namespace lf {
-	struct Reservation {
+	enum class Reclaiming : uint8_t {
+		kInline, kBackground
+	};
+
+	// Where the EBR of subjects constructed afterwards frees retired nodes.
+	inline Reclaiming ebr_reclaiming{ Reclaiming::kInline };
+
+	struct alignas(std::hardware_destructive_interference_size) Reservation {
 		Reservation() = default;
 
-		void StartOP(std::atomic<uint64_t>& base_epoch) {
-			epoch = base_epoch.fetch_add(1, std::memory_order_relaxed);
+		// Announces the current epoch. The fence orders the announcement before the reads of the operation.
+		void StartOP(const std::atomic<uint64_t>& base_epoch) {
+			epoch = base_epoch.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
 		}
 
 		void EndOp() {
@@ -22,21 +38,42 @@ namespace lf {
 		volatile uint64_t epoch{ std::numeric_limits<uint64_t>::max() };
 	};
 
+	/* Epoch-based reclamation in the style of DEBRA.
+	An operation only announces the global epoch, which is advanced by a reclaiming thread
+	once every active thread has announced it. A node retired in epoch e is freed
+	when every active thread has announced an epoch after e.
+	Retired nodes are chained through their retire_epoch, and the epoch is kept per bag
+	of consecutive retirements instead. The bags are reserved up front, and once they are all taken
+	the last one absorbs the newer retirements, so retiring never allocates.
+	With Reclaiming::kBackground, a full retired list is handed to a reclaimer thread
+	through a per-thread ring, so that no operation pays for a scan or a burst of frees. */
 	template<class T>
 	class EBR {
 	public:
 		EBR() = delete;
-		EBR(int num_thread)
-			: num_thread_{ num_thread }, reservations_(num_thread), retired_(num_thread) {
+		// num_hazard is accepted for interchangeability with hazard pointers and hazard eras.
+		EBR(int num_thread, NodePool<T>& pool, int num_hazard = 1)
+			: num_thread_{ num_thread }, reservations_(num_thread), limbos_(num_thread), pool_{ pool } {
+			for (auto& limbo : limbos_) {
+				limbo.bags.reserve(kNumBag);
+				limbo.next_clear = GetCapacity();
+			}
+			if (Reclaiming::kBackground == ebr_reclaiming) {
+				handoffs_ = std::vector<Handoff>(num_thread);
+				reclaimer_ = std::thread{ [this] { RunReclaimer(); } };
+			}
 		}
 		~EBR() noexcept {
-			for (auto& q : retired_) {
-				while (not q.empty()) {
-					auto f = q.front();
-					q.pop();
-					delete f;
-				}
+			if (reclaimer_.joinable()) {
+				is_stopped_.store(true, std::memory_order_release);
+				reclaimer_.join();
+				Collect();
+			}
+			for (auto& limbo : limbos_) {
+				Destroy(limbo);
 			}
+			Destroy(orphans_);
+			Destroy(background_);
 		}
 		EBR(const EBR&) = delete;
 		EBR(EBR&&) = delete;
@@ -44,51 +81,295 @@ namespace lf {
 		EBR& operator=(EBR&&) = delete;
 
 		void Retire(T* ptr) {
-			ptr->retire_epoch = epoch_.load(std::memory_order_relaxed);
-			retired_[MyThreadID::Get()].push(ptr);
-			if (retired_[MyThreadID::Get()].size() >= GetCapacity()) {
-				Clear();
+			Retire(ptr, MyThreadID::Get());
+		}
+
+		// The overloads taking id are for callers that keep their thread ID at hand.
+		void Retire(T* ptr, int id) {
+			auto& limbo = limbos_[id];
+			auto epoch = epoch_.load(std::memory_order_seq_cst);
+			if (limbo.bags.empty()) {
+				limbo.bags.push_back(Bag{ epoch, 0 });
+			} else if (limbo.bags.back().epoch != epoch) {
+				if (limbo.bags.size() < limbo.bags.capacity()) {
+					limbo.bags.push_back(Bag{ epoch, 0 });
+				} else {
+					// Freeing the last bag after the newer epoch only delays it.
+					limbo.bags.back().epoch = epoch;
+				}
+			}
+			limbo.bags.back().size += 1;
+			limbo.num_retired += 1;
+
+			SetNext(ptr, nullptr);
+			if (nullptr == limbo.tail) {
+				limbo.head = ptr;
+			} else {
+				SetNext(limbo.tail, ptr);
+			}
+			limbo.tail = ptr;
+
+			limbo.size += 1;
+			limbo.num = limbo.size;
+			limbo.peak = std::max(limbo.peak, limbo.size);
+			if (limbo.size >= limbo.next_clear) {
+				if (not handoffs_.empty() and HandOff(limbo, id)) {
+					return;
+				}
+				Clear(limbo, id);
 			}
 		}
 
+		// The whole operation is protected, so the pointer is only read.
+		T* Protect(int index, T* volatile& src) {
+			return src;
+		}
+
+		T* Protect(int index, T* volatile& src, int id) {
+			return src;
+		}
+
+		void OnNew(T* ptr) {}
+
 		void StartOp() {
-			reservations_[MyThreadID::Get()].StartOP(epoch_);
+			StartOp(MyThreadID::Get());
+		}
+
+		void StartOp(int id) {
+			reservations_[id].StartOP(epoch_);
 		}
 
 		void EndOp() {
-			reservations_[MyThreadID::Get()].EndOp();
+			EndOp(MyThreadID::Get());
+		}
+
+		void EndOp(int id) {
+			reservations_[id].EndOp();
+		}
+
+		// A thread taking a slot adopts the nodes that departed threads could not reclaim yet.
+		void Register() {
+			std::lock_guard lock{ orphans_mutex_ };
+			Splice(limbos_[MyThreadID::Get()], orphans_);
+		}
+
+		void Unregister() {
+			auto id = MyThreadID::Get();
+			auto& limbo = limbos_[id];
+			Clear(limbo, id);
+			std::lock_guard lock{ orphans_mutex_ };
+			Splice(orphans_, limbo);
+		}
+
+		// Read while other threads run, so the sum is approximate.
+		uint64_t GetNumUnreclaimed() const {
+			uint64_t num{ background_.num };
+			for (const auto& limbo : limbos_) {
+				num += limbo.num;
+			}
+			return num;
+		}
+
+		// The longest retired list of each thread since construction.
+		std::vector<uint64_t> GetPeakNumRetired() const {
+			std::vector<uint64_t> peaks;
+			peaks.reserve(limbos_.size());
+			for (const auto& limbo : limbos_) {
+				peaks.push_back(limbo.peak);
+			}
+			return peaks;
 		}
 
 	private:
+		static constexpr size_t kNumBag{ 64 };
+		static constexpr size_t kNumHandoffBatch{ 64 };
+		static constexpr std::chrono::microseconds kReclaimerInterval{ 100 };
+
+		// Retirements of one epoch, in the order of the retired list.
+		struct Bag {
+			uint64_t epoch;
+			uint64_t size;
+		};
+
+		struct alignas(std::hardware_destructive_interference_size) Limbo {
+			T* head{};
+			T* tail{};
+			std::vector<Bag> bags;
+			uint64_t size{};
+			uint64_t peak{};
+			uint64_t next_clear{};
+			uint64_t num_retired{};
+			uint64_t last_epoch{};
+			volatile uint64_t num{};
+		};
+
+		// A retired list handed to the reclaimer thread. Its nodes are safe after epoch.
+		struct Batch {
+			T* head;
+			T* tail;
+			uint64_t epoch;
+			uint64_t size;
+		};
+
+		// Single-producer ring from a thread to the reclaimer thread.
+		struct Handoff {
+			std::array<Batch, kNumHandoffBatch> batches;
+			alignas(std::hardware_destructive_interference_size) std::atomic<uint64_t> tail{};
+			alignas(std::hardware_destructive_interference_size) std::atomic<uint64_t> head{};
+		};
+
+		static T* GetNext(T* ptr) {
+			return reinterpret_cast<T*>(static_cast<uintptr_t>(ptr->retire_epoch));
+		}
+
+		static void SetNext(T* ptr, T* next) {
+			ptr->retire_epoch = reinterpret_cast<uintptr_t>(next);
+		}
+
+		static void Splice(Limbo& dst, Limbo& src) {
+			if (nullptr == src.head) {
+				return;
+			}
+			if (nullptr == dst.tail) {
+				dst.head = src.head;
+			} else {
+				SetNext(dst.tail, src.head);
+			}
+			dst.tail = src.tail;
+			dst.bags.insert(dst.bags.end(), src.bags.begin(), src.bags.end());
+			dst.size += src.size;
+			dst.num = dst.size;
+			dst.peak = std::max(dst.peak, dst.size);
+
+			src.head = src.tail = nullptr;
+			src.bags.clear();
+			src.size = 0;
+			src.num = 0;
+		}
+
 		uint64_t GetCapacity() const {
 			return static_cast<uint64_t>(num_thread_ * 60);
 		}
 
 		uint64_t GetMinReservation() const {
-			return std::min_element(reservations_.begin(), reservations_.end(),
-				[](const Reservation& a, const Reservation& b) {
-					return a.epoch < b.epoch;
-				})->epoch;
+			// Each reservation is read exactly once; re-reading the minimum could observe a later EndOp.
+			auto min_epoch = std::numeric_limits<uint64_t>::max();
+			for (const auto& reservation : reservations_) {
+				uint64_t epoch = reservation.epoch;
+				if (epoch < min_epoch) {
+					min_epoch = epoch;
+				}
+			}
+			return min_epoch;
 		}
 
-		void Clear() {
+		// Frees through the node cache of thread id.
+		void Clear(Limbo& limbo, int id) {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
 			auto max_safe_epoch = GetMinReservation();
+			auto epoch = epoch_.load(std::memory_order_seq_cst);
+			if (max_safe_epoch >= epoch) {
+				epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+			}
 
-			while (false == retired_[MyThreadID::Get()].empty()) {
-				auto f = retired_[MyThreadID::Get()].front();
-				if (f->retire_epoch >= max_safe_epoch) {
-					break;
+			uint64_t num_free{};
+			auto f = limbo.head;
+			auto bag = limbo.bags.begin();
+			for (; limbo.bags.end() != bag and bag->epoch < max_safe_epoch; ++bag) {
+				f = pool_.DeleteList(f, bag->size, id, GetNext);
+				num_free += bag->size;
+			}
+			limbo.bags.erase(limbo.bags.begin(), bag);
+			limbo.head = f;
+			if (nullptr == f) {
+				limbo.tail = nullptr;
+			}
+
+			limbo.size -= num_free;
+			limbo.num = limbo.size;
+			// A bag can only be freed after the epoch has advanced, so the next scan waits for about
+			// as many retirements as this thread made per epoch since the last one.
+			epoch = epoch_.load(std::memory_order_relaxed);
+			auto num_epoch = std::max<uint64_t>(epoch - limbo.last_epoch, 1);
+			limbo.next_clear = limbo.size + std::max(GetCapacity(), limbo.num_retired / num_epoch);
+			limbo.num_retired = 0;
+			limbo.last_epoch = epoch;
+		}
+
+		// Returns false when the ring is full, and the caller then reclaims by itself.
+		bool HandOff(Limbo& limbo, int id) {
+			auto& handoff = handoffs_[id];
+			auto tail = handoff.tail.load(std::memory_order_relaxed);
+			if (tail - handoff.head.load(std::memory_order_acquire) == kNumHandoffBatch) {
+				return false;
+			}
+			handoff.batches[tail % kNumHandoffBatch] = Batch{ limbo.head, limbo.tail, limbo.bags.back().epoch, limbo.size };
+			handoff.tail.store(tail + 1, std::memory_order_release);
+
+			limbo.head = limbo.tail = nullptr;
+			limbo.bags.clear();
+			limbo.size = 0;
+			limbo.num = 0;
+			return true;
+		}
+
+		// Moves the handed batches into the list of the reclaimer thread. Returns whether there were any.
+		bool Collect() {
+			bool has_batch{};
+			for (auto& handoff : handoffs_) {
+				auto head = handoff.head.load(std::memory_order_relaxed);
+				auto tail = handoff.tail.load(std::memory_order_acquire);
+				for (; head != tail; ++head) {
+					const auto& batch = handoff.batches[head % kNumHandoffBatch];
+					if (nullptr == background_.tail) {
+						background_.head = batch.head;
+					} else {
+						SetNext(background_.tail, batch.head);
+					}
+					background_.tail = batch.tail;
+					background_.bags.push_back(Bag{ batch.epoch, batch.size });
+					background_.size += batch.size;
+					has_batch = true;
+				}
+				handoff.head.store(tail, std::memory_order_release);
+			}
+			background_.num = background_.size;
+			return has_batch;
+		}
+
+		void RunReclaimer() {
+			MyThreadID::Set(MyThreadID::kReclaimerThreadID);
+			while (not is_stopped_.load(std::memory_order_acquire)) {
+				auto has_batch = Collect();
+				if (nullptr != background_.head) {
+					Clear(background_, MyThreadID::kReclaimerThreadID);
+				}
+				if (not has_batch) {
+					std::this_thread::sleep_for(kReclaimerInterval);
 				}
-				retired_[MyThreadID::Get()].pop();
+			}
+		}
 
-				delete f;
+		void Destroy(Limbo& limbo) {
+			auto f = limbo.head;
+			while (nullptr != f) {
+				auto next = GetNext(f);
+				pool_.Destroy(f);
+				f = next;
 			}
 		}
 
 		int num_thread_;
 		std::vector<Reservation> reservations_;
-		std::vector<std::queue<T*>> retired_;
-		std::atomic<uint64_t> epoch_;
+		std::vector<Limbo> limbos_;
+		NodePool<T>& pool_;
+		std::atomic<uint64_t> epoch_{};
+		std::mutex orphans_mutex_;
+		Limbo orphans_;
+		std::vector<Handoff> handoffs_;
+		Limbo background_;
+		std::atomic<bool> is_stopped_{};
+		std::thread reclaimer_;
 	};
 }
 
@@ -1,3 +1,4 @@
+#include <filesystem>
 #include "graph.h"
 
 void Graph::Save()
@@ -6,11 +7,11 @@ void Graph::Save()
 
 	out.write(reinterpret_cast<const char*>(&num_vertex_), sizeof(num_vertex_));
 
-	for (const auto& adj : adjs_) {
+	for (int32_t i = 0; i < num_vertex_; ++i) {
+		auto adj = GetAdjacents(i);
 		auto num_adj = static_cast<int32_t>(adj.size());
 		out.write(reinterpret_cast<const char*>(&num_adj), sizeof(num_adj));
-		out.write(reinterpret_cast<const char*>(adj.data()), num_adj * sizeof(*adj.data()));
-		num_edge_ += num_adj;
+		out.write(reinterpret_cast<const char*>(adj.data()), adj.size_bytes());
 	}
 
 	Reset();
@@ -59,40 +60,61 @@ void Graph::Generate()
 	}
 
 	distances_.resize(num_vertex_, std::numeric_limits<int>::max());
-	adjs_.resize(num_vertex_);
-
-	for (auto& adj : adjs_) {
-		adj.reserve(max_adj);
-	}
+	offsets_.assign(num_vertex_ + 1, 0);
+
+	/* The first pass only counts the degrees to lay out the offsets, and the second pass
+	replays the same random sequence into the edge array. A vertex gains no adjacent
+	after its own turn, so its adjacents are complete when they are shuffled. */
+	std::vector<int32_t> degrees(num_vertex_);
+	for (int pass = 0; pass < 2; ++pass) {
+		auto fills = 1 == pass;
+		std::ranges::fill(degrees, 0);
+		auto add_edge = [&](int32_t from, int32_t to) {
+			if (fills) {
+				edges_[offsets_[from] + degrees[from]] = to;
+			}
+			degrees[from] += 1;
+		};
 
-	std::mt19937 re{ 2025 };
-	std::uniform_int_distribution<int32_t> uid{ 0, num_vertex_ };
+		std::mt19937 re{ 2025 };
+		std::uniform_int_distribution<int32_t> uid{ 0, num_vertex_ };
 
-	for (int32_t i = 0; i < num_vertex_ - 1; ++i) {
-		adjs_[i].push_back(i + 1);
-		adjs_[i + 1].push_back(i);
+		for (int32_t i = 0; i < num_vertex_ - 1; ++i) {
+			add_edge(i, i + 1);
+			add_edge(i + 1, i);
 
-		auto step = uid(re) % 100;
-		if (step <= 1) {
-			continue;
-		}
+			auto step = uid(re) % 100;
+			if (step <= 1) {
+				continue;
+			}
 
-		for (int32_t j = 1; ; ++j) {
-			auto next = i + step * j;
-			if (next >= num_vertex_ or max_adj == adjs_[i].size()) {
-				break;
+			for (int32_t j = 1; ; ++j) {
+				auto next = i + step * j;
+				if (next >= num_vertex_ or max_adj == degrees[i]) {
+					break;
+				}
+				if (max_adj > degrees[next] and max_adj > degrees[i] and uid(re) % 100 < 5) {
+					add_edge(i, next);
+					add_edge(next, i);
+				}
 			}
-			if (max_adj > adjs_[next].size() and max_adj > adjs_[i].size() and uid(re) % 100 < 5) {
-				adjs_[i].push_back(next);
-				adjs_[next].push_back(i);
+
+			for (auto j = degrees[i] - 1; j > 0; --j) {
+				auto r = uid(re) % j;
+				if (fills) {
+					std::swap(edges_[offsets_[i] + j], edges_[offsets_[i] + r]);
+				}
 			}
 		}
 
-		for (auto j = static_cast<int32_t>(adjs_[i].size() - 1); j > 0; --j) {
-			auto r = uid(re) % j;
-			std::swap(adjs_[i][j], adjs_[i][r]);
+		if (not fills) {
+			for (int32_t i = 0; i < num_vertex_; ++i) {
+				offsets_[i + 1] = offsets_[i] + degrees[i];
+			}
+			edges_.resize(offsets_.back());
 		}
 	}
+	num_edge_ = offsets_.back();
 }
 
 void Graph::Load()
@@ -106,17 +128,27 @@ void Graph::Load()
 
 	in.read(reinterpret_cast<char*>(&num_vertex_), sizeof(num_vertex_));
 
+	// The file holds the vertex count, a count and the adjacents per vertex, and the shortest distance.
+	auto file_size = std::filesystem::file_size(std::format("graph{}.bin", static_cast<int>(type_)));
+	auto num_edge = (file_size - 2 * sizeof(int32_t)) / sizeof(int32_t) - num_vertex_;
+
 	distances_.resize(num_vertex_, std::numeric_limits<int32_t>::max());
-	adjs_.resize(num_vertex_);
+	offsets_.resize(num_vertex_ + 1);
+	edges_.resize(num_edge);
 
 	int32_t num_adj{};
-	for (auto& adj : adjs_) {
+	for (int32_t i = 0; i < num_vertex_; ++i) {
 		in.read(reinterpret_cast<char*>(&num_adj), sizeof(num_adj));
-		num_edge_ += num_adj;
-		adj.resize(num_adj);
+		offsets_[i + 1] = offsets_[i] + num_adj;
+		if (offsets_[i + 1] > edges_.size()) {
+			compat::Print("[Error] The graph file is corrupted.\n");
+			num_vertex_ = 0;
+			return;
+		}
 
-		in.read(reinterpret_cast<char*>(adj.data()), num_adj * sizeof(*adj.data()));
+		in.read(reinterpret_cast<char*>(edges_.data() + offsets_[i]), num_adj * sizeof(*edges_.data()));
 	}
+	num_edge_ = offsets_.back();
 
 	in.read(reinterpret_cast<char*>(&shortest_distance_), sizeof(shortest_distance_));
 
@@ -140,7 +172,7 @@ int32_t Graph::SingleThreadBFS()
 
 		auto cost = distances_[p] + 1;
 
-		for (auto adj : adjs_[p]) {
+		for (auto adj : GetAdjacents(p)) {
 			if (cost < distances_[adj]) {
 				distances_[adj] = cost;
 				queue.push(adj);
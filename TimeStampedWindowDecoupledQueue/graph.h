@@ -4,6 +4,7 @@
 #include <atomic>
 #include <fstream>
 #include <vector>
+#include <span>
 #include <random>
 #include <array>
 #include <optional>
@@ -46,7 +47,7 @@ public:
 
 			auto dist = distances_[curr.value()];
 
-			for (auto adj : adjs_[curr.value()]) {
+			for (auto adj : GetAdjacents(curr.value())) {
 				if (adj == dst) {
 					has_ended_ = true;
 					return dist + 1;
@@ -56,7 +57,12 @@ public:
 
 				if (std::numeric_limits<int32_t>::max() == expected_dist) {
 					if (true == CAS(adj, expected_dist, dist + 1)) {
-						queue.Enq(adj);
+						// Priority queues order the vertices by distance.
+						if constexpr (requires { queue.Enq(adj, uint64_t{}); }) {
+							queue.Enq(adj, static_cast<uint64_t>(dist + 1));
+						} else {
+							queue.Enq(adj);
+						}
 					}
 				}
 			}
@@ -81,6 +87,7 @@ public:
 	void PrintStatus() const {
 		compat::Print("     vertices: {}\n", num_vertex_);
 		compat::Print("        edges: {}\n", num_edge_);
+		compat::Print("       memory: {:.1f} MiB\n", GetMemoryFootprint() / 1048576.0);
 		compat::Print("shortest dist: {}\n\n", shortest_distance_);
 	}
 
@@ -105,13 +112,26 @@ private:
 	void Load();
 	int32_t SingleThreadBFS();
 
+	std::span<const int32_t> GetAdjacents(int32_t vertex) const {
+		return std::span<const int32_t>{ edges_.data() + offsets_[vertex], edges_.data() + offsets_[vertex + 1] };
+	}
+
+	// Bytes held by the adjacency and the distances.
+	size_t GetMemoryFootprint() const {
+		return offsets_.capacity() * sizeof(*offsets_.data()) + edges_.capacity() * sizeof(*edges_.data())
+			+ distances_.capacity() * sizeof(*distances_.data());
+	}
+
 	bool CAS(int32_t node, int32_t expected_cost, int32_t desired_cost) {
 		return std::atomic_compare_exchange_strong(
 			reinterpret_cast<std::atomic<int32_t>*>(&distances_[node]),
 			&expected_cost, desired_cost);
 	}
 
-	std::vector<std::vector<int32_t>> adjs_;
+	/* Compressed sparse row: the adjacents of vertex v are edges_[offsets_[v]] to edges_[offsets_[v + 1] - 1].
+	Every type has at most num_vertex * max_adj < 2^32 edges, so 32-bit offsets suffice. */
+	std::vector<uint32_t> offsets_;
+	std::vector<int32_t> edges_;
 	std::vector<int32_t> distances_;
 	int32_t num_vertex_{};
 	uint32_t num_edge_{};
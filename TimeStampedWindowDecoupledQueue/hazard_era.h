@@ -0,0 +1,213 @@
+#ifndef HAZARD_ERA_H
+#define HAZARD_ERA_H
+
+#include <new>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include "my_thread_id.h"
+#include "node_pool.h"
+#include "per_thread_array.h"
+
+namespace lf {
+	/* Hazard eras by Ramalhete and Correia.
+	A node records the eras of its allocation and retirement, and each thread publishes
+	the era it observed when reading a pointer instead of the pointer itself.
+	A retired node is freed once no published era lies within its lifetime, so a stalled thread
+	only keeps alive the nodes that existed in its era, as in interval-based reclamation.
+	Both eras are packed into the 64-bit retire_epoch of the node: the birth era in the upper half. */
+	template<class T>
+	class HazardEra {
+	public:
+		HazardEra() = delete;
+		HazardEra(int num_thread, NodePool<T>& pool, int num_hazard = 1)
+			: num_thread_{ num_thread }, num_hazard_{ num_hazard }
+			, hazards_{ num_thread, static_cast<size_t>(num_hazard) }, retired_(num_thread), pool_{ pool } {
+			for (auto& retired : retired_) {
+				retired.nodes.reserve(GetCapacity());
+				retired.eras.reserve(static_cast<size_t>(num_thread) * num_hazard);
+				retired.used.reserve(num_hazard);
+			}
+		}
+		~HazardEra() noexcept {
+			for (auto& retired : retired_) {
+				for (auto f : retired.nodes) {
+					pool_.Destroy(f);
+				}
+			}
+			for (auto f : orphans_) {
+				pool_.Destroy(f);
+			}
+		}
+		HazardEra(const HazardEra&) = delete;
+		HazardEra(HazardEra&&) = delete;
+		HazardEra& operator=(const HazardEra&) = delete;
+		HazardEra& operator=(HazardEra&&) = delete;
+
+		void StartOp() {}
+
+		void StartOp(int id) {}
+
+		void EndOp() {
+			EndOp(MyThreadID::Get());
+		}
+
+		// Unlike a stale pointer, a stale era would keep every node of that era alive.
+		void EndOp(int id) {
+			auto hazards = hazards_[id];
+			auto& used = retired_[id].used;
+			for (auto index : used) {
+				hazards[index].era = kNone;
+			}
+			used.clear();
+		}
+
+		T* Protect(int index, T* volatile& src) {
+			return Protect(index, src, MyThreadID::Get());
+		}
+
+		// Returns the pointer read from src once the era is seen unchanged after thread id publishes it.
+		T* Protect(int index, T* volatile& src, int id) {
+			auto& hazard = hazards_[id][index];
+			uint64_t prev_era = hazard.era;
+			if (kNone == prev_era) {
+				retired_[id].used.push_back(index);
+			}
+			while (true) {
+				auto ptr = src;
+				auto era = era_.load(std::memory_order_acquire);
+				if (era == prev_era) {
+					return ptr;
+				}
+				hazard.era = era;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				prev_era = era;
+			}
+		}
+
+		void OnNew(T* ptr) {
+			ptr->retire_epoch = era_.load(std::memory_order_relaxed) << 32;
+		}
+
+		void Retire(T* ptr) {
+			Retire(ptr, MyThreadID::Get());
+		}
+
+		void Retire(T* ptr, int id) {
+			auto& retired = retired_[id];
+			ptr->retire_epoch |= era_.load(std::memory_order_relaxed) & kEraMask;
+			retired.nodes.push_back(ptr);
+			retired.num = retired.nodes.size();
+			retired.peak = std::max<uint64_t>(retired.peak, retired.nodes.size());
+
+			retired.num_retire += 1;
+			if (0 == retired.num_retire % kEraFrequency) {
+				era_.fetch_add(1, std::memory_order_acq_rel);
+			}
+			if (retired.nodes.size() >= std::max(GetCapacity(), retired.next_scan)) {
+				Scan(retired, id);
+			}
+		}
+
+		void Register() {
+			std::lock_guard lock{ orphans_mutex_ };
+			auto& retired = retired_[MyThreadID::Get()];
+			retired.nodes.insert(retired.nodes.end(), orphans_.begin(), orphans_.end());
+			retired.num = retired.nodes.size();
+			orphans_.clear();
+		}
+
+		void Unregister() {
+			auto id = MyThreadID::Get();
+			EndOp(id);
+			auto& retired = retired_[id];
+			Scan(retired, id);
+			std::lock_guard lock{ orphans_mutex_ };
+			orphans_.insert(orphans_.end(), retired.nodes.begin(), retired.nodes.end());
+			retired.nodes.clear();
+			retired.num = 0;
+		}
+
+		// Read while other threads run, so the sum is approximate.
+		uint64_t GetNumUnreclaimed() const {
+			uint64_t num{};
+			for (const auto& retired : retired_) {
+				num += retired.num;
+			}
+			return num;
+		}
+
+		std::vector<uint64_t> GetPeakNumRetired() const {
+			std::vector<uint64_t> peaks;
+			peaks.reserve(retired_.size());
+			for (const auto& retired : retired_) {
+				peaks.push_back(retired.peak);
+			}
+			return peaks;
+		}
+
+	private:
+		static constexpr uint64_t kNone{};
+		static constexpr uint64_t kEraMask{ 0xFFFF'FFFF };
+		static constexpr uint64_t kEraFrequency{ 64 };
+
+		struct HazardSlot {
+			volatile uint64_t era{ kNone };
+		};
+
+		struct alignas(std::hardware_destructive_interference_size) Retired {
+			std::vector<T*> nodes;
+			std::vector<uint64_t> eras;
+			std::vector<int> used;
+			uint64_t num_retire{};
+			size_t next_scan{};
+			uint64_t peak{};
+			volatile uint64_t num{};
+		};
+
+		size_t GetCapacity() const {
+			return std::max<size_t>(2 * static_cast<size_t>(num_thread_) * num_hazard_, 64);
+		}
+
+		void Scan(Retired& retired, int id) {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto& eras = retired.eras;
+			eras.clear();
+			for (int i = 0; i < num_thread_; ++i) {
+				for (const auto& hazard : hazards_[i]) {
+					uint64_t era = hazard.era;
+					if (kNone != era) {
+						eras.push_back(era & kEraMask);
+					}
+				}
+			}
+			std::sort(eras.begin(), eras.end());
+
+			std::erase_if(retired.nodes, [&](T* f) {
+				auto birth_era = f->retire_epoch >> 32;
+				auto retire_era = f->retire_epoch & kEraMask;
+				auto era = std::lower_bound(eras.begin(), eras.end(), birth_era);
+				if (eras.end() != era and *era <= retire_era) {
+					return false;
+				}
+				pool_.Delete(f, id);
+				return true;
+				});
+			retired.num = retired.nodes.size();
+			// Nodes kept alive by a stalled thread would otherwise trigger a scan on every retirement.
+			retired.next_scan = 2 * retired.nodes.size();
+		}
+
+		int num_thread_;
+		int num_hazard_;
+		PerThreadArray<HazardSlot> hazards_;
+		std::vector<Retired> retired_;
+		NodePool<T>& pool_;
+		std::mutex orphans_mutex_;
+		std::vector<T*> orphans_;
+		alignas(std::hardware_destructive_interference_size) std::atomic<uint64_t> era_{ 1 };
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+#ifndef HAZARD_POINTER_H
+#define HAZARD_POINTER_H
+
+#include <new>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include "my_thread_id.h"
+#include "node_pool.h"
+#include "per_thread_array.h"
+
+namespace lf {
+	/* Hazard pointers by Maged Michael.
+	Each thread publishes the nodes it is about to dereference in its num_hazard slots,
+	and a retired node is freed once no slot refers to it. A stalled thread keeps
+	at most num_hazard nodes alive, so the number of unreclaimed nodes stays bounded. */
+	template<class T>
+	class HazardPointer {
+	public:
+		HazardPointer() = delete;
+		HazardPointer(int num_thread, NodePool<T>& pool, int num_hazard = 1)
+			: num_thread_{ num_thread }, num_hazard_{ num_hazard }
+			, hazards_{ num_thread, static_cast<size_t>(num_hazard) }, retired_(num_thread), pool_{ pool } {
+			for (auto& retired : retired_) {
+				retired.nodes.reserve(GetCapacity());
+				retired.hazards.reserve(static_cast<size_t>(num_thread) * num_hazard);
+			}
+		}
+		~HazardPointer() noexcept {
+			for (auto& retired : retired_) {
+				for (auto f : retired.nodes) {
+					pool_.Destroy(f);
+				}
+			}
+			for (auto f : orphans_) {
+				pool_.Destroy(f);
+			}
+		}
+		HazardPointer(const HazardPointer&) = delete;
+		HazardPointer(HazardPointer&&) = delete;
+		HazardPointer& operator=(const HazardPointer&) = delete;
+		HazardPointer& operator=(HazardPointer&&) = delete;
+
+		void StartOp() {}
+
+		void StartOp(int id) {}
+
+		// Slots stay published until they are overwritten, which delays at most num_hazard nodes per thread.
+		void EndOp() {}
+
+		void EndOp(int id) {}
+
+		T* Protect(int index, T* volatile& src) {
+			return Protect(index, src, MyThreadID::Get());
+		}
+
+		// Publishes the pointer read from src in a slot of thread id and returns it once src is seen unchanged.
+		T* Protect(int index, T* volatile& src, int id) {
+			auto& hazard = hazards_[id][index];
+			auto ptr = src;
+			while (true) {
+				hazard.ptr = ptr;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				auto again = src;
+				if (again == ptr) {
+					return ptr;
+				}
+				ptr = again;
+			}
+		}
+
+		void OnNew(T* ptr) {}
+
+		void Retire(T* ptr) {
+			Retire(ptr, MyThreadID::Get());
+		}
+
+		void Retire(T* ptr, int id) {
+			auto& retired = retired_[id];
+			retired.nodes.push_back(ptr);
+			retired.num = retired.nodes.size();
+			retired.peak = std::max<uint64_t>(retired.peak, retired.nodes.size());
+			if (retired.nodes.size() >= std::max(GetCapacity(), retired.next_scan)) {
+				Scan(retired, id);
+			}
+		}
+
+		void Register() {
+			std::lock_guard lock{ orphans_mutex_ };
+			auto& retired = retired_[MyThreadID::Get()];
+			retired.nodes.insert(retired.nodes.end(), orphans_.begin(), orphans_.end());
+			retired.num = retired.nodes.size();
+			orphans_.clear();
+		}
+
+		void Unregister() {
+			auto id = MyThreadID::Get();
+			for (auto& hazard : hazards_[id]) {
+				hazard.ptr = nullptr;
+			}
+			auto& retired = retired_[id];
+			Scan(retired, id);
+			std::lock_guard lock{ orphans_mutex_ };
+			orphans_.insert(orphans_.end(), retired.nodes.begin(), retired.nodes.end());
+			retired.nodes.clear();
+			retired.num = 0;
+		}
+
+		// Read while other threads run, so the sum is approximate.
+		uint64_t GetNumUnreclaimed() const {
+			uint64_t num{};
+			for (const auto& retired : retired_) {
+				num += retired.num;
+			}
+			return num;
+		}
+
+		std::vector<uint64_t> GetPeakNumRetired() const {
+			std::vector<uint64_t> peaks;
+			peaks.reserve(retired_.size());
+			for (const auto& retired : retired_) {
+				peaks.push_back(retired.peak);
+			}
+			return peaks;
+		}
+
+	private:
+		struct HazardSlot {
+			T* volatile ptr{};
+		};
+
+		struct alignas(std::hardware_destructive_interference_size) Retired {
+			std::vector<T*> nodes;
+			std::vector<T*> hazards;
+			size_t next_scan{};
+			uint64_t peak{};
+			volatile uint64_t num{};
+		};
+
+		// Scanning costs O(num_thread * num_hazard), so it is amortized over as many retirements.
+		size_t GetCapacity() const {
+			return std::max<size_t>(2 * static_cast<size_t>(num_thread_) * num_hazard_, 64);
+		}
+
+		void Scan(Retired& retired, int id) {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto& hazards = retired.hazards;
+			hazards.clear();
+			for (int i = 0; i < num_thread_; ++i) {
+				for (const auto& hazard : hazards_[i]) {
+					T* ptr = hazard.ptr;
+					if (nullptr != ptr) {
+						hazards.push_back(ptr);
+					}
+				}
+			}
+			std::sort(hazards.begin(), hazards.end());
+
+			std::erase_if(retired.nodes, [&](T* f) {
+				if (std::binary_search(hazards.begin(), hazards.end(), f)) {
+					return false;
+				}
+				pool_.Delete(f, id);
+				return true;
+				});
+			retired.num = retired.nodes.size();
+			// Keeps the scans amortized while many nodes stay protected.
+			retired.next_scan = 2 * retired.nodes.size();
+		}
+
+		int num_thread_;
+		int num_hazard_;
+		PerThreadArray<HazardSlot> hazards_;
+		std::vector<Retired> retired_;
+		NodePool<T>& pool_;
+		std::mutex orphans_mutex_;
+		std::vector<T*> orphans_;
+	};
+}
+
+#endif
\ No newline at end of file
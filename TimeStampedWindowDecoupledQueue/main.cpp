@@ -7,4 +7,5 @@ int main()
 
 	benchmark::Tester tester;
 	tester.Run();
+	return 0 == tester.GetNumBoundViolation() ? 0 : 1;
 }
\ No newline at end of file
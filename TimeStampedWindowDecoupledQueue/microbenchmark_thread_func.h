@@ -1,13 +1,30 @@
 #ifndef MICROBENCHMARK_THREAD_FUNC_H
 #define MICROBENCHMARK_THREAD_FUNC_H
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <limits>
+#include <algorithm>
 #include "random.h"
 #include "my_thread_id.h"
 #include "idle.h"
+#include "allocation_counter.h"
+#include "rank_error_sampler.h"
 
 namespace benchmark {
 	inline const auto kTotalNumOp{ (std::thread::hardware_concurrency() <= 8) ? 360'000 : 18'000'000 };
 	inline constexpr auto kNumPrefill{ 100'000 };
+	inline constexpr auto kNumBurst{ 10 };
+	inline constexpr std::chrono::milliseconds kIdleDuration{ 50 };
+	inline constexpr std::chrono::milliseconds kDeqWaitTimeout{ 10 };
+
+	// Enqueues rejected by a full subject, summed over the threads of a run.
+	inline std::atomic<uint64_t> num_full_enq{};
+
+	// Elements left in the subject by Prefill, summed over its threads.
+	inline std::atomic<uint64_t> num_prefilled{};
 
 	template<class QueueT>
 	void MicrobenchmarkFunc(int thread_id, int num_thread, float enq_rate, 
@@ -15,29 +32,214 @@ namespace benchmark {
 	{
 		MyThreadID::Set(thread_id);
 		int32_t num_op = kTotalNumOp / num_thread;
+		auto num_allocation = AllocationCounter::GetThreadCount();
+		uint64_t num_full{};
+
+		for (int32_t i = 0; i < num_op; ++i) {
+			auto op = Random::Get(0.0f, 100.0f);
+
+			if (op <= enq_rate) {
+				if constexpr (requires { queue.TryEnq(0); }) {
+					if (not queue.TryEnq(Random::Get(0, 9999))) {
+						num_full += 1;
+					}
+				} else {
+					queue.Enq(Random::Get(0, 9999));
+				}
+			} else {
+				auto p = queue.Deq();
+			}
+
+			idle.Do(delay);
+		}
+
+		AllocationCounter::AddToTotal(AllocationCounter::GetThreadCount() - num_allocation);
+		num_full_enq.fetch_add(num_full);
+	}
+
+	// Runs the same operations as MicrobenchmarkFunc and feeds rank_error_sampler on the way.
+	template<class QueueT>
+	void SampledBenchmarkFunc(int thread_id, int num_thread, float enq_rate,
+		float delay, QueueT& queue)
+	{
+		MyThreadID::Set(thread_id);
+		int32_t num_op = kTotalNumOp / num_thread;
+		auto num_allocation = AllocationCounter::GetThreadCount();
+		uint64_t num_full{};
+		int32_t num_enq{};
+
+		for (int32_t i = 0; i < num_op; ++i) {
+			auto op = Random::Get(0.0f, 100.0f);
+
+			if (op <= enq_rate) {
+				auto v = 0 == ++num_enq % RankErrorSampler::kSamplePeriod
+					? rank_error_sampler.Tag() : rank_error_sampler.GetValue();
+				if constexpr (requires { queue.TryEnq(0); }) {
+					if (queue.TryEnq(std::move(v))) {
+						rank_error_sampler.CountEnq(thread_id);
+					} else {
+						num_full += 1;
+					}
+				} else {
+					queue.Enq(v);
+					rank_error_sampler.CountEnq(thread_id);
+				}
+			} else {
+				auto p = queue.Deq();
+				if (p.has_value()) {
+					rank_error_sampler.CountDeq(thread_id, RankErrorSampler::GetDequeuedValue(*p));
+				}
+			}
+
+			idle.Do(delay);
+		}
+
+		AllocationCounter::AddToTotal(AllocationCounter::GetThreadCount() - num_allocation);
+		num_full_enq.fetch_add(num_full);
+	}
+
+	// Runs the same operations as MicrobenchmarkFunc through a handle of the subject.
+	template<class QueueT>
+	void HandleBenchmarkFunc(int thread_id, int num_thread, float enq_rate,
+		float delay, QueueT& queue)
+	{
+		MyThreadID::Set(thread_id);
+		auto handle = queue.GetHandle();
+		int32_t num_op = kTotalNumOp / num_thread;
+		auto num_allocation = AllocationCounter::GetThreadCount();
+		uint64_t num_full{};
+
+		for (int32_t i = 0; i < num_op; ++i) {
+			auto op = Random::Get(0.0f, 100.0f);
+
+			if (op <= enq_rate) {
+				if (not handle.TryEnq(Random::Get(0, 9999))) {
+					num_full += 1;
+				}
+			} else {
+				auto p = handle.Deq();
+			}
+
+			idle.Do(delay);
+		}
+
+		AllocationCounter::AddToTotal(AllocationCounter::GetThreadCount() - num_allocation);
+		num_full_enq.fetch_add(num_full);
+	}
+
+	// Runs the same operations as MicrobenchmarkFunc and records the latency of every dequeue in nanoseconds.
+	template<class QueueT>
+	void LatencyBenchmarkFunc(int thread_id, int num_thread, float enq_rate,
+		float delay, QueueT& queue, std::vector<uint32_t>& latencies)
+	{
+		MyThreadID::Set(thread_id);
+		int32_t num_op = kTotalNumOp / num_thread;
+		latencies.reserve(num_op);
 
 		for (int32_t i = 0; i < num_op; ++i) {
 			auto op = Random::Get(0.0f, 100.0f);
 
 			if (op <= enq_rate) {
-				queue.Enq(Random::Get(0, 9999));
+				if constexpr (requires { queue.TryEnq(0); }) {
+					queue.TryEnq(Random::Get(0, 9999));
+				} else {
+					queue.Enq(Random::Get(0, 9999));
+				}
 			} else {
+				auto start = std::chrono::steady_clock::now();
 				auto p = queue.Deq();
+				auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start).count();
+				latencies.push_back(static_cast<uint32_t>(
+					std::min<int64_t>(ns, std::numeric_limits<uint32_t>::max())));
+			}
+
+			idle.Do(delay);
+		}
+	}
+
+	/* The first half of the threads enqueue in bursts separated by idle phases,
+	and the rest dequeue until every producer has finished and the queue is empty.
+	Consumers block with DeqWait() when the subject provides it, and busy-loop on Deq() otherwise. */
+	template<class QueueT>
+	void IdleBenchmarkFunc(int thread_id, int num_thread, float delay,
+		std::atomic<int>& num_active_producer, QueueT& queue)
+	{
+		MyThreadID::Set(thread_id);
+		auto num_producer = num_thread / 2;
+
+		if (thread_id < num_producer) {
+			int32_t num_op = kTotalNumOp / 2 / num_producer / kNumBurst;
+			for (int burst = 0; burst < kNumBurst; ++burst) {
+				for (int32_t i = 0; i < num_op; ++i) {
+					queue.Enq(Random::Get(0, 9999));
+					idle.Do(delay);
+				}
+				std::this_thread::sleep_for(kIdleDuration);
 			}
+			num_active_producer.fetch_sub(1);
+			return;
+		}
 
+		while (true) {
+			auto is_done = 0 == num_active_producer.load();
+			bool has_value{};
+			if constexpr (requires { queue.DeqWait(kDeqWaitTimeout); }) {
+				has_value = queue.DeqWait(kDeqWaitTimeout).has_value();
+			} else {
+				has_value = queue.Deq().has_value();
+			}
+			if (not has_value and is_done) {
+				return;
+			}
 			idle.Do(delay);
 		}
 	}
 
+	// Retired by ReclamationBenchmarkFunc without ever being linked.
+	struct ReclaimedNode {
+		ReclaimedNode* volatile next{};
+		uint64_t retire_epoch{};
+	};
+
+	/* Makes the reclamation calls of queue operations without a queue: every operation
+	protects a shared pointer, and every other one retires a node as a dequeue would. */
+	template<class Reclaimer, class Pool>
+	void ReclamationBenchmarkFunc(int thread_id, int num_thread, Reclaimer& reclaimer,
+		Pool& pool, ReclaimedNode* volatile& shared)
+	{
+		MyThreadID::Set(thread_id);
+		int32_t num_op = kTotalNumOp / num_thread;
+
+		for (int32_t i = 0; i < num_op; ++i) {
+			reclaimer.StartOp();
+			auto p = reclaimer.Protect(0, shared);
+			if (0 == i % 2) {
+				auto node = pool.New();
+				reclaimer.OnNew(node);
+				reclaimer.Retire(node);
+			}
+			reclaimer.EndOp();
+		}
+	}
+
 	template<class QueueT>
 	void Prefill(int thread_id, int num_thread, QueueT& queue)
 	{
 		MyThreadID::Set(thread_id);
 		int32_t num_op = kNumPrefill / num_thread;
+		int32_t i = 0;
 
-		for (int32_t i = 0; i < num_op; ++i) {
-			queue.Enq(Random::Get(0, 65535));
+		for (; i < num_op; ++i) {
+			if constexpr (requires { queue.TryEnq(0); }) {
+				if (not queue.TryEnq(Random::Get(0, 65535))) {
+					break;
+				}
+			} else {
+				queue.Enq(Random::Get(0, 65535));
+			}
 		}
+		num_prefilled.fetch_add(i);
 	}
 }
 
@@ -0,0 +1,31 @@
+#ifndef MODE_TYPE_H
+#define MODE_TYPE_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace benchmark {
+	enum class Mode : uint8_t {
+		kThroughput, kRelaxation, kIdle, kStall, kReclamation, kLatency, kCacheMiss, kHandle, kInstrumentation, kSampling, kCapacity
+	};
+
+	inline std::string GetModeName(Mode mode)
+	{
+		constexpr std::array<const char*, 11> names{
+			"throughput", "relaxation distance", "CPU time with idle phases",
+			"throughput and unreclaimed nodes with a stalled thread",
+			"overhead of memory reclamation per operation",
+			"dequeue latency with inline and background reclamation",
+			"throughput and hardware cache misses",
+			"throughput of TSWD through thread IDs and through handles",
+			"throughput with the relaxation distance checked at runtime and compiled out",
+			"throughput with the relaxation distance sampled",
+			"throughput of TSWD unbounded and bounded at 50% and 70% enqueue rates"
+		};
+
+		return names[static_cast<int>(mode)];
+	}
+}
+
+#endif
\ No newline at end of file
@@ -13,6 +13,10 @@ public:
 		}
 		id_ = id;
 	}
+	// Lets a thread that left a dynamic structure take another ID later.
+	static void Reset() {
+		id_ = kUndefinedThreadID;
+	}
 	static int Get() {
 		if (kUndefinedThreadID == id_) [[unlikely]] {
 			compat::Print("[Error] Must register thread ID first.\n");
@@ -22,6 +26,8 @@ public:
 	}
 
 	static constexpr int kMainThreadID{ -1 };
+	// The background reclaimer of EBR, which frees through a node cache of its own.
+	static constexpr int kReclaimerThreadID{ -2 };
 private:
 	static constexpr int kUndefinedThreadID{ std::numeric_limits<int>::min() };
 	static thread_local int id_;
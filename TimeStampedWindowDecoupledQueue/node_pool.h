@@ -0,0 +1,254 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <new>
+#include <atomic>
+#include <vector>
+#include <bit>
+#include <cstdlib>
+#include <cstdint>
+#include <utility>
+#include <numeric>
+#include "my_thread_id.h"
+
+namespace lf {
+	enum class Allocation : uint8_t {
+		kHeap, kPool
+	};
+
+	// Allocation used by the node pools of subjects constructed afterwards.
+	inline Allocation node_allocation{ Allocation::kPool };
+
+	/* Per-thread slab allocator for queue nodes.
+	Each thread carves nodes out of its own 64 KiB slabs. A node freed by another thread
+	is gathered into a batch and pushed back to the owner's remote list with a single CAS,
+	so the slabs of enqueuers are refilled by dequeuers instead of by the global heap. */
+	template<class T>
+	class NodePool {
+	public:
+		NodePool() = delete;
+		NodePool(int num_thread)
+			: allocation_{ node_allocation }, caches_(num_thread + 2) {
+			for (auto& cache : caches_) {
+				cache.pending.resize(caches_.size());
+			}
+		}
+		~NodePool() {
+			for (auto& cache : caches_) {
+				for (auto slab : cache.slabs) {
+					std::free(slab);
+				}
+			}
+		}
+		NodePool(const NodePool&) = delete;
+		NodePool(NodePool&&) = delete;
+		NodePool& operator=(const NodePool&) = delete;
+		NodePool& operator=(NodePool&&) = delete;
+
+		template<class... Args>
+		T* New(Args&&... args) {
+			return NewFor(MyThreadID::Get(), std::forward<Args>(args)...);
+		}
+
+		// Allocates from the cache of thread id. Not an overload of New, which may take an int as well.
+		template<class... Args>
+		T* NewFor(int id, Args&&... args) {
+			auto& cache = GetCache(id);
+			if (Allocation::kHeap == allocation_) {
+				cache.num_allocation += 1;
+				return new T(std::forward<Args>(args)...);
+			}
+			return new (Allocate(cache)) T(std::forward<Args>(args)...);
+		}
+
+		void Delete(T* ptr) {
+			Delete(ptr, MyThreadID::Get());
+		}
+
+		void Delete(T* ptr, int id) {
+			if (Allocation::kHeap == allocation_) {
+				delete ptr;
+				return;
+			}
+			ptr->~T();
+			Free(reinterpret_cast<Slot*>(ptr), id);
+		}
+
+		// Frees num nodes chained through get_next and returns the node after them.
+		// Nodes of the own slabs are pushed onto the free list as one chain.
+		template<class Next>
+		T* DeleteList(T* first, uint64_t num, int id, Next get_next) {
+			if (Allocation::kHeap == allocation_) {
+				for (uint64_t i = 0; i < num; ++i) {
+					auto next = get_next(first);
+					delete first;
+					first = next;
+				}
+				return first;
+			}
+
+			auto& cache = GetCache(id);
+			auto index = GetCacheIndex(cache);
+			Batch own{};
+			for (uint64_t i = 0; i < num; ++i) {
+				auto next = get_next(first);
+				first->~T();
+				auto slot = reinterpret_cast<Slot*>(first);
+				auto owner = GetSlabHeader(slot)->owner;
+				if (index == owner) {
+					slot->next = own.first;
+					own.first = slot;
+					if (nullptr == own.last) {
+						own.last = slot;
+					}
+				} else {
+					FreeRemote(cache, slot, owner);
+				}
+				first = next;
+			}
+			if (nullptr != own.first) {
+				own.last->next = cache.free;
+				cache.free = own.first;
+			}
+			return first;
+		}
+
+		// Releases a node during teardown. The slab itself is freed by the destructor.
+		void Destroy(T* ptr) {
+			if (Allocation::kHeap == allocation_) {
+				delete ptr;
+				return;
+			}
+			ptr->~T();
+		}
+
+		uint64_t GetNumAllocation() const {
+			return std::accumulate(caches_.begin(), caches_.end(), uint64_t{},
+				[](uint64_t acc, const Cache& cache) {
+					return acc + cache.num_allocation;
+				});
+		}
+
+	private:
+		union Slot {
+			Slot* next;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		struct Batch {
+			Slot* first{};
+			Slot* last{};
+			int32_t size{};
+		};
+
+		struct alignas(std::hardware_destructive_interference_size) SlabHeader {
+			int32_t owner;
+		};
+
+		struct alignas(std::hardware_destructive_interference_size) Cache {
+			Slot* free{};
+			std::vector<void*> slabs;
+			std::vector<Batch> pending;
+			uint64_t num_allocation{};
+			alignas(std::hardware_destructive_interference_size) std::atomic<Slot*> remote{};
+		};
+
+		static constexpr size_t kCacheLineSize{ std::hardware_destructive_interference_size };
+
+		// A slot never straddles two cache lines.
+		static constexpr size_t kSlotSize{ sizeof(Slot) <= kCacheLineSize
+			? std::bit_ceil(sizeof(Slot))
+			: (sizeof(Slot) + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize };
+		static constexpr size_t kSlabSize{ 64 * 1024 };
+		static constexpr size_t kNumSlotPerSlab{ (kSlabSize - sizeof(SlabHeader)) / kSlotSize };
+		static constexpr int32_t kRemoteBatchSize{ 32 };
+
+		static_assert(kNumSlotPerSlab > 0, "Node is too large for a slab.");
+
+		// The main thread and the reclaimer thread have the last two caches.
+		Cache& GetCache(int id) {
+			if (MyThreadID::kMainThreadID == id) [[unlikely]] {
+				return caches_[caches_.size() - 2];
+			}
+			if (MyThreadID::kReclaimerThreadID == id) [[unlikely]] {
+				return caches_.back();
+			}
+			return caches_[id];
+		}
+
+		int32_t GetCacheIndex(const Cache& cache) const {
+			return static_cast<int32_t>(&cache - caches_.data());
+		}
+
+		void* Allocate(Cache& cache) {
+			if (nullptr == cache.free) {
+				cache.free = cache.remote.exchange(nullptr, std::memory_order_acquire);
+			}
+			if (nullptr == cache.free) {
+				AddSlab(cache);
+			}
+			auto slot = cache.free;
+			cache.free = slot->next;
+			return slot;
+		}
+
+		void Free(Slot* slot, int id) {
+			auto& cache = GetCache(id);
+			auto owner = GetSlabHeader(slot)->owner;
+			if (GetCacheIndex(cache) == owner) {
+				slot->next = cache.free;
+				cache.free = slot;
+				return;
+			}
+			FreeRemote(cache, slot, owner);
+		}
+
+		void FreeRemote(Cache& cache, Slot* slot, int32_t owner) {
+			auto& batch = cache.pending[owner];
+			slot->next = batch.first;
+			batch.first = slot;
+			if (nullptr == batch.last) {
+				batch.last = slot;
+			}
+			batch.size += 1;
+
+			if (kRemoteBatchSize == batch.size) {
+				auto& remote = caches_[owner].remote;
+				auto head = remote.load(std::memory_order_relaxed);
+				do {
+					batch.last->next = head;
+				} while (not remote.compare_exchange_weak(head, batch.first,
+					std::memory_order_release, std::memory_order_relaxed));
+				batch = Batch{};
+			}
+		}
+
+		void AddSlab(Cache& cache) {
+			auto slab = std::aligned_alloc(kSlabSize, kSlabSize);
+			if (nullptr == slab) [[unlikely]] {
+				throw std::bad_alloc{};
+			}
+			cache.slabs.push_back(slab);
+			cache.num_allocation += 1;
+
+			new (slab) SlabHeader{ GetCacheIndex(cache) };
+
+			auto base = static_cast<unsigned char*>(slab) + sizeof(SlabHeader);
+			for (size_t i = kNumSlotPerSlab; i > 0; --i) {
+				auto slot = reinterpret_cast<Slot*>(base + (i - 1) * kSlotSize);
+				slot->next = cache.free;
+				cache.free = slot;
+			}
+		}
+
+		static SlabHeader* GetSlabHeader(Slot* slot) {
+			return reinterpret_cast<SlabHeader*>(
+				reinterpret_cast<uintptr_t>(slot) & ~static_cast<uintptr_t>(kSlabSize - 1));
+		}
+
+		Allocation allocation_;
+		std::vector<Cache> caches_;
+	};
+}
+
+#endif
\ No newline at end of file
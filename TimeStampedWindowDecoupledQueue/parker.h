@@ -0,0 +1,55 @@
+#ifndef PARKER_H
+#define PARKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace lf {
+	/* Lets consumers sleep on a futex until a producer signals.
+	A producer only issues a syscall while at least one consumer is parked. */
+	class alignas(std::hardware_destructive_interference_size) Parker {
+	public:
+		Parker() = default;
+
+		// Must be followed by a final emptiness check, then Park() or Cancel().
+		uint32_t Prepare() {
+			num_sleeper_.fetch_add(1, std::memory_order_seq_cst);
+			return signal_.load(std::memory_order_seq_cst);
+		}
+
+		void Cancel() {
+			num_sleeper_.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		void Park(uint32_t signal, std::chrono::nanoseconds timeout) {
+			auto sec = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+			timespec ts{ static_cast<time_t>(sec.count()),
+				static_cast<long>((timeout - sec).count()) };
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&signal_),
+				FUTEX_WAIT_PRIVATE, signal, &ts, nullptr, 0);
+			num_sleeper_.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		// Must be called after the element has been published.
+		void Unpark(int num_wake = 1) {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (0 == num_sleeper_.load(std::memory_order_relaxed)) [[likely]] {
+				return;
+			}
+			signal_.fetch_add(1, std::memory_order_seq_cst);
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&signal_),
+				FUTEX_WAKE_PRIVATE, num_wake, nullptr, nullptr, 0);
+		}
+
+	private:
+		std::atomic<uint32_t> num_sleeper_{};
+		std::atomic<uint32_t> signal_{};
+	};
+}
+
+#endif
\ No newline at end of file
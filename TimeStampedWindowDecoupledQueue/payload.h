@@ -0,0 +1,20 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <array>
+#include <cstddef>
+
+namespace benchmark {
+	// Fixed-size element used to measure the cost of storing larger values inside the nodes.
+	template<size_t kSize> requires (kSize >= sizeof(int) and 0 == kSize % sizeof(int))
+	struct Payload {
+		Payload() = default;
+		Payload(int v) {
+			data.front() = v;
+		}
+
+		std::array<int, kSize / sizeof(int)> data{};
+	};
+}
+
+#endif
\ No newline at end of file
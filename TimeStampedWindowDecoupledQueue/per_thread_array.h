@@ -0,0 +1,35 @@
+#ifndef PER_THREAD_ARRAY_H
+#define PER_THREAD_ARRAY_H
+
+#include <new>
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace lf {
+	// Scratch arrays sized at construction, one per thread, so that hot paths never allocate.
+	template<class T>
+	class PerThreadArray {
+	public:
+		PerThreadArray(int num_thread, size_t size)
+			: size_{ size }, stride_{ GetStride(size) }, data_(num_thread * stride_) {}
+
+		std::span<T> operator[](int thread_id) {
+			return std::span<T>{ data_.data() + thread_id * stride_, size_ };
+		}
+
+	private:
+		// Rows are padded by an extra cache line, so rows of different threads never share one.
+		static size_t GetStride(size_t size) {
+			constexpr size_t kNumPerLine{ std::max<size_t>(
+				std::hardware_destructive_interference_size / sizeof(T), 1) };
+			return (size + kNumPerLine - 1) / kNumPerLine * kNumPerLine + kNumPerLine;
+		}
+
+		size_t size_;
+		size_t stride_;
+		std::vector<T> data_;
+	};
+}
+
+#endif
\ No newline at end of file
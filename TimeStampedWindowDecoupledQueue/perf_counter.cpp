@@ -0,0 +1,72 @@
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf_counter.h"
+#include "print.h"
+
+namespace benchmark {
+	CacheMissCounter::CacheMissCounter()
+		: cache_miss_fd_{ Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES) }
+		, l1d_miss_fd_{ Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+			| (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)) }
+	{
+		if (not IsValid()) {
+			compat::Print("[Error] perf_event_open failed: {}. Hardware counters may be missing "
+				"or restricted by /proc/sys/kernel/perf_event_paranoid.\n", std::strerror(errno));
+		}
+	}
+
+	CacheMissCounter::~CacheMissCounter()
+	{
+		for (auto fd : { cache_miss_fd_, l1d_miss_fd_ }) {
+			if (fd >= 0) {
+				close(fd);
+			}
+		}
+	}
+
+	void CacheMissCounter::Start()
+	{
+		for (auto fd : { cache_miss_fd_, l1d_miss_fd_ }) {
+			if (fd >= 0) {
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+	}
+
+	CacheMissCounter::Count CacheMissCounter::Stop()
+	{
+		for (auto fd : { cache_miss_fd_, l1d_miss_fd_ }) {
+			if (fd >= 0) {
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			}
+		}
+		return Count{ Read(cache_miss_fd_), Read(l1d_miss_fd_) };
+	}
+
+	int CacheMissCounter::Open(uint32_t type, uint64_t config)
+	{
+		perf_event_attr attr{};
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.inherit = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+
+	uint64_t CacheMissCounter::Read(int fd)
+	{
+		uint64_t count{};
+		if (fd < 0 or sizeof(count) != read(fd, &count, sizeof(count))) {
+			return 0;
+		}
+		return count;
+	}
+}
\ No newline at end of file
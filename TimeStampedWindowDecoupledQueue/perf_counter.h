@@ -0,0 +1,40 @@
+#ifndef PERF_COUNTER_H
+#define PERF_COUNTER_H
+
+#include <cstdint>
+
+namespace benchmark {
+	/* Cache misses counted by the hardware through perf_event_open.
+	The counters are opened with inherit set, so they also count the threads created
+	by the calling thread afterwards, once those threads have been joined.
+	HITM events are specific to each microarchitecture, so the generic last-level cache misses
+	and L1D load misses are counted instead. Both grow with false sharing. */
+	class CacheMissCounter {
+	public:
+		struct Count {
+			uint64_t num_cache_miss;
+			uint64_t num_l1d_miss;
+		};
+
+		CacheMissCounter();
+		~CacheMissCounter();
+		CacheMissCounter(const CacheMissCounter&) = delete;
+		CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+		bool IsValid() const {
+			return cache_miss_fd_ >= 0 and l1d_miss_fd_ >= 0;
+		}
+
+		void Start();
+		Count Stop();
+
+	private:
+		static int Open(uint32_t type, uint64_t config);
+		static uint64_t Read(int fd);
+
+		int cache_miss_fd_;
+		int l1d_miss_fd_;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef PLACEMENT_TYPE_H
+#define PLACEMENT_TYPE_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace benchmark {
+	enum class Placement : uint8_t {
+		kNone, kLocal, kInterleaved
+	};
+
+	inline std::string GetPlacementName(Placement placement)
+	{
+		constexpr std::array<const char*, 3> names{
+			"none", "socket-local", "interleaved"
+		};
+
+		return names[static_cast<int>(placement)];
+	}
+}
+
+#endif
\ No newline at end of file
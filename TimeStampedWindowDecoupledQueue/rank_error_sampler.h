@@ -0,0 +1,143 @@
+#ifndef RANK_ERROR_SAMPLER_H
+#define RANK_ERROR_SAMPLER_H
+
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <concepts>
+#include "relaxation_distance.h"
+
+namespace benchmark {
+	/* Estimates the rank error of a sample of the elements while the throughput is measured.
+	Every thread counts its enqueues in its own cache line, and one in kSamplePeriod enqueues of a thread
+	tags its element with a slot holding the number of elements enqueued before it. Every other element
+	carries its epoch, the number of slots taken before it, and every thread counts its dequeues per epoch
+	in its own Fenwick tree. When a tagged element is dequeued, the elements dequeued before it from its
+	epoch and earlier ones are older, so its rank error is the number enqueued before it less those.
+	This is exact up to the operations in flight. Prefilled elements are below every epoch. */
+	class RankErrorSampler {
+	public:
+		static constexpr int kSamplePeriod{ 256 };
+
+		void Reset(int num_thread, uint64_t num_prefilled, size_t max_num_sample) {
+			counters_ = std::vector<Counter>(num_thread);
+			for (auto& counter : counters_) {
+				counter.num_deq = std::vector<std::atomic<uint32_t>>(max_num_sample + 2);
+			}
+			samples_ = std::vector<Sample>(max_num_sample);
+			num_prefilled_ = num_prefilled;
+			num_sample_ = 0;
+		}
+
+		// The value to enqueue for an untagged element.
+		int GetValue() const {
+			return kEpochBase + static_cast<int>(std::min(num_sample_.load(std::memory_order_relaxed), samples_.size()));
+		}
+
+		// Returns a tag to enqueue, or an untagged value once every slot is taken.
+		int Tag() {
+			auto slot = num_sample_.fetch_add(1, std::memory_order_relaxed);
+			if (slot >= samples_.size()) {
+				return GetValue();
+			}
+			samples_[slot].num_enq_before = num_prefilled_ + SumEnq();
+			return kTagBase + static_cast<int>(slot);
+		}
+
+		void CountEnq(int thread_id) {
+			Increment(counters_[thread_id].num_enq);
+		}
+
+		void CountDeq(int thread_id, int value) {
+			if (value >= kTagBase) {
+				auto slot = static_cast<size_t>(value - kTagBase);
+				auto& sample = samples_[slot];
+				auto num_older_deq = SumDeq(slot);
+				sample.rd = sample.num_enq_before > num_older_deq ? sample.num_enq_before - num_older_deq : 0;
+				sample.thread_id = thread_id;
+				sample.is_dequeued = true;
+			}
+
+			// Slot k lies between the elements of epoch k and those of epoch k + 1.
+			auto& tree = counters_[thread_id].num_deq;
+			auto index = value >= kTagBase ? value - kTagBase + 1 : std::max(value - kEpochBase, 0);
+			for (auto i = static_cast<size_t>(index) + 1; i < tree.size(); i += i & (~i + 1)) {
+				Increment(tree[i]);
+			}
+		}
+
+		template<class T>
+		static int GetDequeuedValue(const T& v) {
+			if constexpr (std::integral<T>) {
+				return v;
+			} else {
+				return v.data.front();
+			}
+		}
+
+		// Only dequeued samples are reported, and they have no partial queue.
+		RelaxationDistanceReport GetRelaxationDistance() const {
+			RelaxationDistanceReport report;
+			for (const auto& sample : samples_) {
+				if (sample.is_dequeued) {
+					report.total.Add(sample.rd);
+					report.per_thread[sample.thread_id].Add(sample.rd);
+				}
+			}
+			return report;
+		}
+
+	private:
+		// Prefilled values lie below the epochs, and the epochs below the tags.
+		static constexpr int kEpochBase{ 1 << 19 };
+		static constexpr int kTagBase{ 1 << 20 };
+
+		// Written by its owner on every operation and read by the threads taking a sample.
+		struct alignas(std::hardware_destructive_interference_size) Counter {
+			std::atomic<uint64_t> num_enq{};
+			// A Fenwick tree over the prefilled elements, the epochs and the slots in between.
+			std::vector<std::atomic<uint32_t>> num_deq;
+		};
+
+		struct Sample {
+			uint64_t num_enq_before{};
+			uint64_t rd{};
+			int thread_id{};
+			bool is_dequeued{};
+		};
+
+		template<class U>
+		static void Increment(std::atomic<U>& cnt) {
+			cnt.store(cnt.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		uint64_t SumEnq() const {
+			uint64_t sum{};
+			for (const auto& counter : counters_) {
+				sum += counter.num_enq.load(std::memory_order_relaxed);
+			}
+			return sum;
+		}
+
+		// Sums the dequeues of the prefilled elements and of epochs 0 to slot.
+		uint64_t SumDeq(size_t slot) const {
+			uint64_t sum{};
+			for (const auto& counter : counters_) {
+				for (auto i = slot + 1; i > 0; i -= i & (~i + 1)) {
+					sum += counter.num_deq[i].load(std::memory_order_relaxed);
+				}
+			}
+			return sum;
+		}
+
+		std::vector<Counter> counters_;
+		std::vector<Sample> samples_;
+		uint64_t num_prefilled_{};
+		std::atomic<size_t> num_sample_{};
+	};
+
+	inline RankErrorSampler rank_error_sampler;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef RECLAMATION_TYPE_H
+#define RECLAMATION_TYPE_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace benchmark {
+	enum class Reclamation : uint8_t {
+		kNone, kEBR, kHazardPointer, kHazardEra, kEBRBackground
+	};
+
+	inline std::string GetReclamationName(Reclamation reclamation)
+	{
+		constexpr std::array<const char*, 5> names{
+			"none", "EBR", "hazard pointers", "hazard eras", "EBR (background)"
+		};
+
+		return names[static_cast<int>(reclamation)];
+	}
+}
+
+#endif
\ No newline at end of file
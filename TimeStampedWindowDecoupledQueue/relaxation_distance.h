@@ -1,88 +1,522 @@
 #ifndef RELAXATION_DISTANCE_H
 #define RELAXATION_DISTANCE_H
 
-#include <list>
-#include <mutex>
-#include <deque>
-#include <utility>
+#include <map>
+#include <bit>
+#include <array>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
 #include <limits>
+#include <optional>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include "my_thread_id.h"
+#include "print.h"
 
 namespace benchmark {
+	// Percentiles of the relaxation distance in the relaxation distance check.
+	inline constexpr std::array<double, 4> kRelaxationPercentiles{ 50.0, 90.0, 99.0, 99.9 };
+
+	// Exact counts of the relaxation distances, kept sparse since most dequeues see small distances.
+	class RelaxationDistanceHistogram {
+	public:
+		void Add(uint64_t rd, uint64_t cnt = 1) {
+			counts_[rd] += cnt;
+			num_element_ += cnt;
+			sum_ += rd * cnt;
+		}
+
+		void Merge(const RelaxationDistanceHistogram& other) {
+			for (auto [rd, cnt] : other.counts_) {
+				Add(rd, cnt);
+			}
+		}
+
+		uint64_t GetNumElement() const {
+			return num_element_;
+		}
+
+		uint64_t GetSum() const {
+			return sum_;
+		}
+
+		uint64_t GetMax() const {
+			return counts_.empty() ? 0 : counts_.rbegin()->first;
+		}
+
+		// The percentiles of kRelaxationPercentiles followed by the maximum.
+		std::array<uint64_t, kRelaxationPercentiles.size() + 1> GetPercentiles() const {
+			std::array<uint64_t, kRelaxationPercentiles.size() + 1> percentiles{};
+			for (size_t i = 0; i < kRelaxationPercentiles.size() and 0 != num_element_; ++i) {
+				auto rank = std::min(num_element_ - 1,
+					static_cast<uint64_t>(num_element_ * kRelaxationPercentiles[i] / 100.0));
+				uint64_t num_below{};
+				for (auto [rd, cnt] : counts_) {
+					num_below += cnt;
+					if (num_below > rank) {
+						percentiles[i] = rd;
+						break;
+					}
+				}
+			}
+			percentiles.back() = GetMax();
+			return percentiles;
+		}
+
+		const std::map<uint64_t, uint64_t>& GetCounts() const {
+			return counts_;
+		}
+
+	private:
+		std::map<uint64_t, uint64_t> counts_;
+		uint64_t num_element_{};
+		uint64_t sum_{};
+	};
+
+	/* A dequeue that took an element farther from the head than the bound allows.
+	Enqueues and dequeues are numbered in the merged history, and times count from its first event. */
+	struct RelaxationBoundViolation {
+		uint64_t rd;
+		uint64_t deq_index;
+		int thread;
+		int queue;
+		/* The window from the oldest element still present to the dequeued one, by enqueue number for a queue
+		and by priority for a priority queue, where first_ns is not known. */
+		uint64_t first;
+		uint64_t last;
+		uint64_t first_ns;
+		uint64_t deq_ns;
+		bool is_by_priority;
+	};
+
+	/* The relaxation distances of a run, also broken down by the dequeuing thread
+	and by the partial queue dequeued from. Partial queues are numbered in address order,
+	which is their index as every subject keeps them in one array. */
+	struct RelaxationDistanceReport {
+		RelaxationDistanceHistogram total;
+		std::map<int, RelaxationDistanceHistogram> per_thread;
+		std::vector<RelaxationDistanceHistogram> per_queue;
+		/* Set when the dequeues were validated against a bound. A dequeue over the bound but within
+		the tolerance is only counted, and the first kMaxNumViolation beyond it are kept. */
+		std::optional<uint64_t> bound;
+		uint64_t tolerance{};
+		uint64_t num_within_tolerance{};
+		uint64_t num_violation{};
+		std::vector<RelaxationBoundViolation> violations;
+	};
+
+	/* Records the operations once CheckRelaxationDistance() is called. Each thread appends
+	(time stamp, node or priority) to its own log without locks, and GetRelaxationDistance()
+	merges the logs in time stamp order after the threads have joined.
+	Insertions are stamped by Stamp() before their linearizing step and removals right after theirs,
+	so a thread preempted in between only shifts the distances of others by one.
+	The distance of a dequeue is the number of elements enqueued before it and not yet dequeued. */
 	class RelaxationDistanceManager {
 	public:
 		RelaxationDistanceManager() = default;
 
 		void CheckRelaxationDistance() {
+			logs_.resize(kMaxNumLog);
 			checks_relaxation_distance_ = true;
 		}
 
-		void LockEnq() {
-			if (checks_relaxation_distance_) {
-				mx_enq_.lock();
+		/* Validates every dequeue of a queue against the bound when the distances are counted.
+		The tolerance covers the operations in flight around a dequeue, as stamps are not taken at the linearization points. */
+		void CheckRelaxationBound(uint64_t bound, uint64_t tolerance) {
+			bound_ = bound;
+			tolerance_ = tolerance;
+		}
+
+		uint64_t Stamp() const {
+			if (not checks_relaxation_distance_) {
+				return 0;
 			}
+			return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+		}
+
+		void Enq(void* node, uint64_t stamp) {
+			Record(Kind::kEnq, reinterpret_cast<uintptr_t>(node), 0, stamp);
+		}
+
+		void Deq(void* node, const void* queue) {
+			Record(Kind::kDeq, reinterpret_cast<uintptr_t>(node), 0, Stamp(), queue);
+		}
+
+		// The distance of a removal from a priority queue is the number of present elements with a smaller priority.
+		void Insert(uint64_t priority, uint64_t stamp) {
+			Insert(priority, priority, stamp);
 		}
 
-		void UnlockEnq() {
-			if (checks_relaxation_distance_) {
-				mx_enq_.unlock();
+		void Remove(uint64_t priority, const void* queue) {
+			Remove(priority, priority, queue);
+		}
+
+		/* Time-stamped queues rank a dequeue by the present elements whose time stamp precedes its own.
+		An interval [lower, upper] precedes another only if it ends before the other begins,
+		so elements with overlapping intervals may leave in either order. */
+		void Insert(uint64_t lower, uint64_t upper, uint64_t stamp) {
+			Record(Kind::kInsert, lower, upper, stamp);
+		}
+
+		void Remove(uint64_t lower, uint64_t upper, const void* queue) {
+			Record(Kind::kRemove, lower, upper, Stamp(), queue);
+		}
+
+		// Stacks rank a pop by the number of present elements pushed after it.
+		void Push(void* node, uint64_t stamp) {
+			Record(Kind::kPush, reinterpret_cast<uintptr_t>(node), 0, stamp);
+		}
+
+		void Pop(void* node, const void* stack) {
+			Record(Kind::kPop, reinterpret_cast<uintptr_t>(node), 0, Stamp(), stack);
+		}
+
+		RelaxationDistanceReport GetRelaxationDistance() const {
+			if (not checks_relaxation_distance_) {
+				return RelaxationDistanceReport{};
+			}
+
+			auto events = MergeLogs();
+			auto is_queue = std::all_of(events.begin(), events.end(), [](const Event& event) {
+				return Kind::kEnq == event.kind or Kind::kDeq == event.kind;
+				});
+			return is_queue ? GetDistance(events, bound_, tolerance_)
+				: GetRankError(GetPriorityEvents(events), bound_, tolerance_);
+		}
+
+		static constexpr size_t kMaxNumViolation{ 16 };
+
+	private:
+		static constexpr uint64_t kMaxSeq{ std::numeric_limits<uint64_t>::max() };
+		static constexpr uint64_t kUnpaired{ std::numeric_limits<uint64_t>::max() };
+		static constexpr size_t kMaxNumLog{ 1024 };
+
+		enum class Kind : uint8_t { kEnq, kDeq, kInsert, kRemove, kPush, kPop };
+
+		struct Event {
+			uint64_t time_stamp;
+			uint64_t key;
+			uint64_t upper_key;
+			const void* queue;
+			int32_t thread;
+			Kind kind;
+		};
+
+		// Written only by its thread while the operations run.
+		struct Log {
+			std::vector<Event> events;
+		};
+
+		struct PriorityEvent {
+			PriorityEvent(uint64_t lower, uint64_t upper, const Event& event)
+				: lower{ lower }, upper{ upper }, time_stamp{ event.time_stamp }, queue{ event.queue }, thread{ event.thread }
+				, is_insertion{ Kind::kInsert == event.kind or Kind::kPush == event.kind } {}
+
+			uint64_t lower;
+			uint64_t upper;
+			uint64_t time_stamp;
+			const void* queue;
+			int32_t thread;
+			bool is_insertion;
+		};
+
+		// Collects the report with the partial queues keyed by address until Finish() numbers them.
+		class ReportBuilder {
+		public:
+			void Add(uint64_t rd, int thread, const void* queue) {
+				report_.total.Add(rd);
+				report_.per_thread[thread].Add(rd);
+				per_queue_[queue].Add(rd);
+			}
+
+			void AddWithinTolerance() {
+				report_.num_within_tolerance += 1;
+			}
+
+			void AddViolation(const RelaxationBoundViolation& violation, const void* queue) {
+				report_.num_violation += 1;
+				if (report_.violations.size() < kMaxNumViolation) {
+					report_.violations.push_back(violation);
+					violation_queues_.push_back(queue);
+				}
+			}
+
+			RelaxationDistanceReport Finish(std::optional<uint64_t> bound = std::nullopt, uint64_t tolerance = 0) {
+				for (auto& [queue, histogram] : per_queue_) {
+					report_.per_queue.push_back(std::move(histogram));
+				}
+				for (size_t i = 0; i < report_.violations.size(); ++i) {
+					auto it = per_queue_.find(violation_queues_[i]);
+					report_.violations[i].queue = static_cast<int>(std::distance(per_queue_.begin(), it));
+				}
+				report_.bound = bound;
+				report_.tolerance = tolerance;
+				return std::move(report_);
+			}
+
+		private:
+			RelaxationDistanceReport report_;
+			std::map<const void*, RelaxationDistanceHistogram> per_queue_;
+			std::vector<const void*> violation_queues_;
+		};
+
+		// Counts over the indices from 0 to size - 1.
+		class FenwickTree {
+		public:
+			FenwickTree(size_t size) : tree_(size + 1) {}
+
+			void Add(size_t index, int64_t delta) {
+				for (auto i = index + 1; i < tree_.size(); i += i & (~i + 1)) {
+					tree_[i] += delta;
+				}
+			}
+
+			// Sums the counts below index.
+			int64_t GetPrefixSum(size_t index) const {
+				int64_t sum{};
+				for (auto i = index; i > 0; i -= i & (~i + 1)) {
+					sum += tree_[i];
+				}
+				return sum;
+			}
+
+			// Returns the index of the n-th counted element, for n from 1 to the total count.
+			size_t Find(int64_t n) const {
+				size_t pos{};
+				for (auto step = std::bit_floor(tree_.size() - 1); step > 0; step >>= 1) {
+					if (pos + step < tree_.size() and tree_[pos + step] < n) {
+						pos += step;
+						n -= tree_[pos];
+					}
+				}
+				return pos;
+			}
+
+		private:
+			std::vector<int64_t> tree_;
+		};
+
+		void Record(Kind kind, uint64_t key, uint64_t upper_key, uint64_t stamp, const void* queue = nullptr) {
+			if (not checks_relaxation_distance_) {
+				return;
+			}
+
+			auto thread = MyThreadID::Get();
+			auto index = static_cast<size_t>(thread + 1);
+			if (index >= logs_.size()) [[unlikely]] {
+				compat::Print("[Error] The relaxation distance is recorded for at most {} threads.\n", kMaxNumLog - 1);
+				exit(getchar());
 			}
+			auto& log = logs_[index];
+			if (nullptr == log) [[unlikely]] {
+				log = std::make_unique<Log>();
+			}
+			log->events.push_back(Event{ stamp, key, upper_key, queue, thread, kind });
 		}
 
-		void LockDeq() {
-			if (checks_relaxation_distance_) {
-				mx_deq_.lock();
+		std::vector<Event> MergeLogs() const {
+			size_t num_event{};
+			for (const auto& log : logs_) {
+				if (nullptr != log) {
+					num_event += log->events.size();
+				}
+			}
+
+			std::vector<Event> events;
+			events.reserve(num_event);
+			for (const auto& log : logs_) {
+				if (nullptr != log) {
+					events.insert(events.end(), log->events.begin(), log->events.end());
+				}
 			}
+			std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+				return a.time_stamp < b.time_stamp;
+				});
+			return events;
 		}
 
-		void UnlockDeq() {
-			if (checks_relaxation_distance_) {
-				mx_deq_.unlock();
+		/* Pairs the k-th removal of a node with its k-th insertion, since the node pool reuses addresses.
+		Returns the index of the insertion of each removal, or kUnpaired. */
+		static std::vector<uint64_t> PairByNode(const std::vector<uint64_t>& insertions,
+			const std::vector<uint64_t>& removals) {
+			auto sort_by_node = [](const std::vector<uint64_t>& nodes) {
+				std::vector<uint64_t> indices(nodes.size());
+				std::iota(indices.begin(), indices.end(), uint64_t{});
+				std::stable_sort(indices.begin(), indices.end(), [&nodes](uint64_t a, uint64_t b) {
+					return nodes[a] < nodes[b];
+					});
+				return indices;
+			};
+			auto sorted_insertions = sort_by_node(insertions);
+			auto sorted_removals = sort_by_node(removals);
+
+			std::vector<uint64_t> pairs(removals.size(), kUnpaired);
+			size_t i{};
+			for (auto removal : sorted_removals) {
+				while (i < sorted_insertions.size() and insertions[sorted_insertions[i]] < removals[removal]) {
+					++i;
+				}
+				if (i < sorted_insertions.size() and insertions[sorted_insertions[i]] == removals[removal]) {
+					pairs[removal] = sorted_insertions[i];
+					++i;
+				}
 			}
+			return pairs;
 		}
 
-		void Enq(void* node) {
-			if (checks_relaxation_distance_) {
-				enq_elements_.push_back(node);
+		/* Counts the elements still present in front of each dequeued one with a Fenwick tree over the enqueue order.
+		A dequeue farther than the bound and the tolerance is reported with the window back to the oldest element present. */
+		static RelaxationDistanceReport GetDistance(const std::vector<Event>& events,
+			std::optional<uint64_t> bound, uint64_t tolerance) {
+			std::vector<uint64_t> enq_nodes;
+			std::vector<uint64_t> enq_stamps;
+			std::vector<uint64_t> deq_nodes;
+			std::vector<const Event*> deqs;
+			for (const auto& event : events) {
+				if (Kind::kEnq == event.kind) {
+					enq_nodes.push_back(event.key);
+					enq_stamps.push_back(event.time_stamp);
+				} else {
+					deq_nodes.push_back(event.key);
+					deqs.push_back(&event);
+				}
+			}
+			auto pairs = PairByNode(enq_nodes, deq_nodes);
+
+			FenwickTree present(enq_nodes.size());
+			for (size_t i = 0; i < enq_nodes.size(); ++i) {
+				present.Add(i, 1);
+			}
+
+			ReportBuilder builder;
+			for (size_t i = 0; i < pairs.size(); ++i) {
+				auto enq = pairs[i];
+				if (kUnpaired == enq) {
+					continue;
+				}
+				auto rd = static_cast<uint64_t>(present.GetPrefixSum(enq));
+				if (bound.has_value() and rd > *bound and rd <= *bound + tolerance) {
+					builder.AddWithinTolerance();
+				} else if (bound.has_value() and rd > *bound) {
+					auto first_enq = present.Find(1);
+					builder.AddViolation(RelaxationBoundViolation{ rd, i, deqs[i]->thread, 0,
+						first_enq, enq, enq_stamps[first_enq] - events.front().time_stamp,
+						deqs[i]->time_stamp - events.front().time_stamp, false }, deqs[i]->queue);
+				}
+				present.Add(enq, -1);
+				builder.Add(rd, deqs[i]->thread, deqs[i]->queue);
 			}
+
+			return builder.Finish(bound, tolerance);
 		}
 
-		void Deq(void* node) {
-			if (checks_relaxation_distance_) {
-				deq_elements_.push_back(node);
+		// Turns pushes and pops into insertions and removals ranked by their push order.
+		static std::vector<PriorityEvent> GetPriorityEvents(const std::vector<Event>& events) {
+			std::vector<uint64_t> push_nodes;
+			std::vector<uint64_t> pop_nodes;
+			for (const auto& event : events) {
+				if (Kind::kPush == event.kind) {
+					push_nodes.push_back(event.key);
+				} else if (Kind::kPop == event.kind) {
+					pop_nodes.push_back(event.key);
+				}
 			}
+			auto pairs = PairByNode(push_nodes, pop_nodes);
+
+			std::vector<PriorityEvent> priority_events;
+			priority_events.reserve(events.size());
+			uint64_t num_push{};
+			uint64_t num_pop{};
+			for (const auto& event : events) {
+				switch (event.kind) {
+				case Kind::kInsert:
+				case Kind::kRemove:
+					priority_events.emplace_back(event.key, event.upper_key, event);
+					break;
+				case Kind::kPush:
+					priority_events.emplace_back(kMaxSeq - num_push, kMaxSeq - num_push, event);
+					num_push += 1;
+					break;
+				case Kind::kPop:
+					if (auto seq = pairs[num_pop++]; kUnpaired != seq) {
+						priority_events.emplace_back(kMaxSeq - seq, kMaxSeq - seq, event);
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			return priority_events;
 		}
 
-		auto GetRelaxationDistance() {
-			if (not checks_relaxation_distance_) {
-				return std::make_tuple(uint64_t{}, uint64_t{}, uint64_t{});
+		/* Replays the events with a Fenwick tree over the distinct upper ends.
+		A removal counts the present elements whose upper end lies below its lower end, and one farther than
+		the bound and the tolerance is reported with the window back to the smallest priority present. */
+		static RelaxationDistanceReport GetRankError(const std::vector<PriorityEvent>& priority_events,
+			std::optional<uint64_t> bound, uint64_t tolerance) {
+			std::vector<uint64_t> uppers;
+			uppers.reserve(priority_events.size());
+			for (const auto& event : priority_events) {
+				uppers.push_back(event.upper);
 			}
+			std::sort(uppers.begin(), uppers.end());
+			uppers.erase(std::unique(uppers.begin(), uppers.end()), uppers.end());
 
-			uint64_t sum_rd{};
-			uint64_t max_rd{};
+			auto get_index = [&uppers](uint64_t key) {
+				return static_cast<size_t>(std::lower_bound(uppers.begin(), uppers.end(), key) - uppers.begin());
+			};
 
-			for (auto i = deq_elements_.cbegin(); i != deq_elements_.cend(); ++i) {
-				uint64_t cnt_skip{};
-				for (auto j = enq_elements_.cbegin(); j != enq_elements_.cend(); ++j, ++cnt_skip) {
-					if (*i == *j) {
-						enq_elements_.erase(j);
-						sum_rd += cnt_skip;
-						if (cnt_skip > max_rd) {
-							max_rd = cnt_skip;
-						}
-						break;
+			FenwickTree present(uppers.size());
+			ReportBuilder builder;
+			uint64_t num_removal{};
+			for (const auto& event : priority_events) {
+				if (not event.is_insertion) {
+					auto rd = static_cast<uint64_t>(present.GetPrefixSum(get_index(event.lower)));
+					if (bound.has_value() and rd > *bound and rd <= *bound + tolerance) {
+						builder.AddWithinTolerance();
+					} else if (bound.has_value() and rd > *bound) {
+						builder.AddViolation(RelaxationBoundViolation{ rd, num_removal, event.thread, 0,
+							uppers[present.Find(1)], event.lower, 0,
+							event.time_stamp - priority_events.front().time_stamp, true }, event.queue);
 					}
+					builder.Add(rd, event.thread, event.queue);
+					num_removal += 1;
 				}
+				present.Add(get_index(event.upper), event.is_insertion ? 1 : -1);
 			}
 
-			return std::make_tuple(deq_elements_.size(), sum_rd, max_rd);
+			return builder.Finish(bound, tolerance);
 		}
 
-	private:
 		bool checks_relaxation_distance_{};
-		std::mutex mx_enq_;
-		std::mutex mx_deq_;
-		std::deque<void*> deq_elements_;
-		std::list<void*> enq_elements_;
+		std::optional<uint64_t> bound_;
+		uint64_t tolerance_{};
+		std::vector<std::unique_ptr<Log>> logs_;
+	};
+
+	/* Instrumentation policy of subjects that are not measured. Every member compiles to nothing,
+	and as an empty member with [[no_unique_address]] it takes no storage in the subject. */
+	class NullRelaxationDistanceManager {
+	public:
+		void CheckRelaxationDistance() {}
+		void CheckRelaxationBound(uint64_t bound, uint64_t tolerance) {}
+		uint64_t Stamp() const { return 0; }
+		void Enq(void* node, uint64_t stamp) {}
+		void Deq(void* node, const void* queue) {}
+		void Insert(uint64_t priority, uint64_t stamp) {}
+		void Remove(uint64_t priority, const void* queue) {}
+		void Insert(uint64_t lower, uint64_t upper, uint64_t stamp) {}
+		void Remove(uint64_t lower, uint64_t upper, const void* queue) {}
+		void Push(void* node, uint64_t stamp) {}
+		void Pop(void* node, const void* stack) {}
+
+		RelaxationDistanceReport GetRelaxationDistance() const {
+			return RelaxationDistanceReport{};
+		}
 	};
 }
 
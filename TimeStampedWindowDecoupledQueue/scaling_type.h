@@ -0,0 +1,23 @@
+#ifndef SCALING_TYPE_H
+#define SCALING_TYPE_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace benchmark {
+	enum class Scaling : uint8_t {
+		kThread, kDepth, kPayload, kWidth
+	};
+
+	inline std::string GetScalingName(Scaling scaling)
+	{
+		constexpr std::array<const char*, 4> names{
+			"thread", "depth", "payload size", "width"
+		};
+
+		return names[static_cast<int>(scaling)];
+	}
+}
+
+#endif
\ No newline at end of file
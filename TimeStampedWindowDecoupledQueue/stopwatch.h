@@ -2,6 +2,7 @@
 #define STOPWATCH_H
 
 #include <chrono>
+#include <ctime>
 
 class Stopwatch {
 public:
@@ -19,4 +20,18 @@ private:
 	Clock::time_point time_point_;
 };
 
+// Measures the CPU time consumed by all threads of the process.
+class CpuStopwatch {
+public:
+	CpuStopwatch() noexcept : clock_{ std::clock() } {}
+	void Start() noexcept {
+		clock_ = std::clock();
+	}
+	double GetDuration() const noexcept {
+		return static_cast<double>(std::clock() - clock_) / CLOCKS_PER_SEC;
+	}
+private:
+	std::clock_t clock_;
+};
+
 #endif
\ No newline at end of file
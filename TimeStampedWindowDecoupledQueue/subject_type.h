@@ -7,14 +7,14 @@
 
 namespace benchmark {
 	enum class Subject : uint8_t {
-		kNone, kTSCAS, kTSStutter, kTSAtomic, kTSInterval, kCBO, k2Dd, kTSWD
+		kNone, kTSCAS, kTSStutter, kTSAtomic, kTSInterval, kCBO, k2Dd, kTSWD, kTSWDMP, kTSWDPQ, kTSWDStack
 	};
 
 	inline std::string GetSubjectName(Subject subject)
 	{
-		constexpr std::array<const char*, 8> names{
+		constexpr std::array<const char*, 11> names{
 			"None", "TS-CAS", "TS-stutter", "TS-atomic", "TS-interval",
-			"d-CBO", "2Dd", "TSWD"
+			"d-CBO", "2Dd", "TSWD", "TSWD-MP", "TSWD-PQ", "TSWD-stack"
 		};
 
 		return names[static_cast<int>(subject)];
@@ -0,0 +1,103 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <numeric>
+#include <pthread.h>
+#include <sched.h>
+#include "topology.h"
+
+namespace benchmark {
+	Topology::Topology()
+	{
+		for (int node = 0; ; ++node) {
+			std::ifstream file{ "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist" };
+			if (not file) {
+				break;
+			}
+			std::string cpu_list;
+			std::getline(file, cpu_list);
+			auto cpus = ParseCpuList(cpu_list);
+			if (not cpus.empty()) {
+				node_cpus_.push_back(std::move(cpus));
+			}
+		}
+
+		if (node_cpus_.empty()) {
+			node_cpus_.emplace_back(std::max(std::thread::hardware_concurrency(), 1u));
+			std::iota(node_cpus_.front().begin(), node_cpus_.front().end(), 0);
+		}
+
+		for (size_t node = 0; node < node_cpus_.size(); ++node) {
+			for (auto cpu : node_cpus_[node]) {
+				local_cpus_.push_back(cpu);
+				if (cpu_nodes_.size() <= static_cast<size_t>(cpu)) {
+					cpu_nodes_.resize(cpu + 1);
+				}
+				cpu_nodes_[cpu] = static_cast<int>(node);
+			}
+		}
+
+		for (size_t i = 0; interleaved_cpus_.size() < local_cpus_.size(); ++i) {
+			for (auto& cpus : node_cpus_) {
+				if (i < cpus.size()) {
+					interleaved_cpus_.push_back(cpus[i]);
+				}
+			}
+		}
+	}
+
+	int Topology::GetCpu(int thread_id, Placement placement) const
+	{
+		auto& cpus = Placement::kInterleaved == placement ? interleaved_cpus_ : local_cpus_;
+		return cpus[thread_id % cpus.size()];
+	}
+
+	int Topology::GetNode(int thread_id, Placement placement) const
+	{
+		if (Placement::kNone == placement) {
+			return 0;
+		}
+		return cpu_nodes_[GetCpu(thread_id, placement)];
+	}
+
+	std::vector<int> Topology::GetNodes(int num_thread, Placement placement) const
+	{
+		std::vector<int> nodes(num_thread);
+		for (int thread_id = 0; thread_id < num_thread; ++thread_id) {
+			nodes[thread_id] = GetNode(thread_id, placement);
+		}
+		return nodes;
+	}
+
+	void Topology::Pin(std::thread& thread, int thread_id, Placement placement) const
+	{
+		if (Placement::kNone == placement) {
+			return;
+		}
+
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		CPU_SET(GetCpu(thread_id, placement), &cpu_set);
+		pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+	}
+
+	// Parses a list such as "0-27,56-83".
+	std::vector<int> Topology::ParseCpuList(const std::string& cpu_list)
+	{
+		std::vector<int> cpus;
+		std::stringstream ss{ cpu_list };
+		std::string range;
+		while (std::getline(ss, range, ',')) {
+			if (range.empty()) {
+				continue;
+			}
+			auto dash = range.find('-');
+			auto first = std::stoi(range.substr(0, dash));
+			auto last = std::string::npos == dash ? first : std::stoi(range.substr(dash + 1));
+			for (auto cpu = first; cpu <= last; ++cpu) {
+				cpus.push_back(cpu);
+			}
+		}
+		return cpus;
+	}
+}
\ No newline at end of file
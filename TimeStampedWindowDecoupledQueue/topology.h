@@ -0,0 +1,36 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include "placement_type.h"
+
+namespace benchmark {
+	/* NUMA nodes and their CPUs read from sysfs.
+	Socket-local placement fills the CPUs of one node before moving on to the next,
+	and interleaved placement alternates between the nodes. */
+	class Topology {
+	public:
+		Topology();
+
+		int GetNumNode() const {
+			return static_cast<int>(node_cpus_.size());
+		}
+
+		int GetCpu(int thread_id, Placement placement) const;
+		int GetNode(int thread_id, Placement placement) const;
+		std::vector<int> GetNodes(int num_thread, Placement placement) const;
+		void Pin(std::thread& thread, int thread_id, Placement placement) const;
+
+	private:
+		static std::vector<int> ParseCpuList(const std::string& cpu_list);
+
+		std::vector<std::vector<int>> node_cpus_;
+		std::vector<int> local_cpus_;
+		std::vector<int> interleaved_cpus_;
+		std::vector<int> cpu_nodes_;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -6,8 +6,10 @@
 #include <vector>
 #include <chrono>
 #include <limits>
+#include <concepts>
 #include "idle.h"
 #include "ebr.h"
+#include "per_thread_array.h"
 #include "relaxation_distance.h"
 #include "stopwatch.h"
 
@@ -42,6 +44,14 @@ namespace lf::ts_cas {
 		bool operator<(const TimeStamp& rhs) const {
 			return t2_ < rhs.t1_;
 		}
+
+		uint64_t GetLower() const {
+			return t1_;
+		}
+
+		uint64_t GetUpper() const {
+			return t2_;
+		}
 	private:
 		using Clock = std::chrono::steady_clock;
 		using Resolution = std::chrono::microseconds;
@@ -50,35 +60,41 @@ namespace lf::ts_cas {
 		uint64_t t2_;
 	};
 
+	template<class T>
 	struct Node {
 		Node() = default;
-		Node(int v, volatile uint64_t& cnt, int delay) : v{ v }, time_stamp{ cnt, delay } {}
+		Node(T v, volatile uint64_t& cnt, int delay) : v{ std::move(v) }, time_stamp{ cnt, delay } {}
 
 		Node* volatile next{};
 		uint64_t retire_epoch{};
 		TimeStamp time_stamp{};
-		int v{};
+		T v{};
 	};
 
+	template<class T>
 	class PartialQueue {
 	public:
-		PartialQueue() : tail_{ new Node }, head_{ tail_ } {}
+		using Node = ts_cas::Node<T>;
+
+		PartialQueue(NodePool<Node>& pool) : pool_{ pool }, tail_{ pool.New() }, head_{ tail_ } {}
 		~PartialQueue() {
 			while (nullptr != head_->next) {
 				Node* t = head_;
 				head_ = head_->next;
-				delete t;
+				pool_.Destroy(t);
 			}
-			delete head_;
+			pool_.Destroy(head_);
 		}
 
-		void Enq(int v, volatile uint64_t& cnt, int delay) {
-			auto node = new Node{ v, cnt, delay };
+		void Enq(T v, volatile uint64_t& cnt, int delay, benchmark::RelaxationDistanceManager& rdm) {
+			auto stamp = rdm.Stamp();
+			auto node = pool_.New(std::move(v), cnt, delay);
+			rdm.Insert(node->time_stamp.GetLower(), node->time_stamp.GetUpper(), stamp);
 			tail_->next = node;
 			tail_ = node;
 		}
 
-		std::optional<int> TryDeq(EBR<Node>& ebr, Node* first) {
+		std::optional<T> TryDeq(EBR<Node>& ebr, Node* first, benchmark::RelaxationDistanceManager& rdm) {
 			auto loc_head = head_;
 			if (loc_head->next != first) {
 				return std::nullopt;
@@ -86,8 +102,10 @@ namespace lf::ts_cas {
 			if (false == CAS(head_, loc_head, first)) {
 				return std::nullopt;
 			}
+			rdm.Remove(first->time_stamp.GetLower(), first->time_stamp.GetUpper(), this);
+			std::optional<T> value{ std::move(first->v) };
 			ebr.Retire(loc_head);
-			return first->v;
+			return value;
 		}
 
 		const auto GetHead() const {
@@ -101,35 +119,53 @@ namespace lf::ts_cas {
 				&expected, desired);
 		}
 
+		NodePool<Node>& pool_;
 		alignas(std::hardware_destructive_interference_size) Node* volatile tail_;
 		alignas(std::hardware_destructive_interference_size) Node* volatile head_;
 	};
 
+	template<class T = int> requires std::movable<T> and std::default_initializable<T>
 	class TSCAS {
 	public:
+		using Node = ts_cas::Node<T>;
+
 		TSCAS(int num_thread, int delay_microsec) : delay_microsec_{ delay_microsec }
-			, queues_(num_thread) , ebr_{ num_thread } {}
+			, pool_{ num_thread }, ebr_{ num_thread, pool_ }
+			, old_heads_{ num_thread, static_cast<size_t>(num_thread) } {
+			queues_.reserve(num_thread);
+			for (int i = 0; i < num_thread; ++i) {
+				queues_.emplace_back(pool_);
+			}
+		}
 
 		void CheckRelaxationDistance() {
-			// Does not support
+			rdm_.CheckRelaxationDistance();
 		}
 
 		auto GetRelaxationDistance() {
-			return rdm_.GetRelaxationDistance(); // Returns (0, 0, 0)
+			return rdm_.GetRelaxationDistance();
+		}
+
+		auto GetNumAllocation() const {
+			return pool_.GetNumAllocation();
+		}
+
+		auto GetPeakNumRetired() const {
+			return ebr_.GetPeakNumRetired();
 		}
 
-		void Enq(int v) {
-			queues_[MyThreadID::Get()].Enq(v, cnt_, delay_microsec_);
+		void Enq(T v) {
+			queues_[MyThreadID::Get()].Enq(std::move(v), cnt_, delay_microsec_, rdm_);
 		}
 
-		std::optional<int> Deq() {
+		std::optional<T> Deq() {
 			ebr_.StartOp();
 			size_t id = MyThreadID::Get();
+			auto old_heads = old_heads_[MyThreadID::Get()];
 			while (true) {
 				TimeStamp min_time_stamp{ std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max() };
 				Node* youngest{};
-				PartialQueue* trg{};
-				std::vector<Node*> old_heads(queues_.size());
+				PartialQueue<T>* trg{};
 
 				for (size_t i = 0; i < queues_.size(); ++i) {
 					auto head = queues_[id].GetHead();
@@ -156,7 +192,7 @@ namespace lf::ts_cas {
 						}
 					}
 				} else {
-					auto value = trg->TryDeq(ebr_, youngest);
+					auto value = trg->TryDeq(ebr_, youngest, rdm_);
 					if (value.has_value()) {
 						ebr_.EndOp();
 						return value;
@@ -167,8 +203,10 @@ namespace lf::ts_cas {
 	private:
 		int delay_microsec_;
 		volatile uint64_t cnt_{ 1 };
-		std::vector<PartialQueue> queues_;
+		NodePool<Node> pool_;
+		std::vector<PartialQueue<T>> queues_;
 		EBR<Node> ebr_;
+		PerThreadArray<Node*> old_heads_;
 		benchmark::RelaxationDistanceManager rdm_;
 	};
 }
@@ -6,40 +6,48 @@
 #include <vector>
 #include <chrono>
 #include <limits>
+#include <concepts>
 #include "ebr.h"
+#include "per_thread_array.h"
 #include "relaxation_distance.h"
 #include "stopwatch.h"
 
 namespace lf::ts_stutter {
+	template<class T>
 	struct Node {
 		Node() = default;
-		Node(int v, uint64_t time_stamp) : v{ v }, time_stamp{ time_stamp } {}
+		Node(T v, uint64_t time_stamp) : v{ std::move(v) }, time_stamp{ time_stamp } {}
 
 		Node* volatile next{};
 		uint64_t retire_epoch{};
 		uint64_t time_stamp{};
-		int v{};
+		T v{};
 	};
 
+	template<class T>
 	class PartialQueue {
 	public:
-		PartialQueue() : tail_{ new Node }, head_{ tail_ } {}
+		using Node = ts_stutter::Node<T>;
+
+		PartialQueue(NodePool<Node>& pool) : pool_{ pool }, tail_{ pool.New() }, head_{ tail_ } {}
 		~PartialQueue() {
 			while (nullptr != head_->next) {
 				Node* t = head_;
 				head_ = head_->next;
-				delete t;
+				pool_.Destroy(t);
 			}
-			delete head_;
+			pool_.Destroy(head_);
 		}
 
-		void Enq(int v, uint64_t time_stamp) {
-			auto node = new Node{ v, time_stamp };
+		void Enq(T v, uint64_t time_stamp, benchmark::RelaxationDistanceManager& rdm) {
+			auto stamp = rdm.Stamp();
+			auto node = pool_.New(std::move(v), time_stamp);
+			rdm.Insert(time_stamp, stamp);
 			tail_->next = node;
 			tail_ = node;
 		}
 
-		std::optional<int> TryDeq(EBR<Node>& ebr, Node* first) {
+		std::optional<T> TryDeq(EBR<Node>& ebr, Node* first, benchmark::RelaxationDistanceManager& rdm) {
 			auto loc_head = head_;
 			if (loc_head->next != first) {
 				return std::nullopt;
@@ -47,8 +55,10 @@ namespace lf::ts_stutter {
 			if (false == CAS(head_, loc_head, first)) {
 				return std::nullopt;
 			}
+			rdm.Remove(first->time_stamp, this);
+			std::optional<T> value{ std::move(first->v) };
 			ebr.Retire(loc_head);
-			return first->v;
+			return value;
 		}
 
 		const auto GetHead() const {
@@ -62,40 +72,59 @@ namespace lf::ts_stutter {
 				&expected, desired);
 		}
 
+		NodePool<Node>& pool_;
 		alignas(std::hardware_destructive_interference_size) Node* volatile tail_;
 		alignas(std::hardware_destructive_interference_size) Node* volatile head_;
 	};
 
-	struct ThreadLocalCounter {
+	// Written by its owner on every enqueue and read by the others, so it takes a cache line of its own.
+	struct alignas(std::hardware_destructive_interference_size) ThreadLocalCounter {
 		ThreadLocalCounter() = default;
 
 		volatile uint64_t cnt{ 1 };
 	};
 
+	template<class T = int> requires std::movable<T> and std::default_initializable<T>
 	class TSStutter {
 	public:
-		TSStutter(int num_thread) : tl_cnts_(num_thread), queues_(num_thread), ebr_{ num_thread } {}
+		using Node = ts_stutter::Node<T>;
+
+		TSStutter(int num_thread) : tl_cnts_(num_thread), pool_{ num_thread }, ebr_{ num_thread, pool_ }
+			, old_heads_{ num_thread, static_cast<size_t>(num_thread) } {
+			queues_.reserve(num_thread);
+			for (int i = 0; i < num_thread; ++i) {
+				queues_.emplace_back(pool_);
+			}
+		}
 
 		void CheckRelaxationDistance() {
-			// Does not support
+			rdm_.CheckRelaxationDistance();
 		}
 
 		auto GetRelaxationDistance() {
-			return rdm_.GetRelaxationDistance(); // Returns (0, 0, 0)
+			return rdm_.GetRelaxationDistance();
+		}
+
+		auto GetNumAllocation() const {
+			return pool_.GetNumAllocation();
+		}
+
+		auto GetPeakNumRetired() const {
+			return ebr_.GetPeakNumRetired();
 		}
 
-		void Enq(int v) {
-			queues_[MyThreadID::Get()].Enq(v, GetNewTimeStamp());
+		void Enq(T v) {
+			queues_[MyThreadID::Get()].Enq(std::move(v), GetNewTimeStamp(), rdm_);
 		}
 
-		std::optional<int> Deq() {
+		std::optional<T> Deq() {
 			ebr_.StartOp();
 			size_t id = MyThreadID::Get();
+			auto old_heads = old_heads_[MyThreadID::Get()];
 			while (true) {
 				uint64_t min_time_stamp{ std::numeric_limits<uint64_t>::max() };
 				Node* youngest{};
-				PartialQueue* trg{};
-				std::vector<Node*> old_heads(queues_.size());
+				PartialQueue<T>* trg{};
 
 				for (size_t i = 0; i < queues_.size(); ++i) {
 					auto head = queues_[id].GetHead();
@@ -122,7 +151,7 @@ namespace lf::ts_stutter {
 						}
 					}
 				} else {
-					auto value = trg->TryDeq(ebr_, youngest);
+					auto value = trg->TryDeq(ebr_, youngest, rdm_);
 					if (value.has_value()) {
 						ebr_.EndOp();
 						return value;
@@ -145,8 +174,10 @@ namespace lf::ts_stutter {
 		}
 
 		std::vector<ThreadLocalCounter> tl_cnts_;
-		std::vector<PartialQueue> queues_;
+		NodePool<Node> pool_;
+		std::vector<PartialQueue<T>> queues_;
 		EBR<Node> ebr_;
+		PerThreadArray<Node*> old_heads_;
 		benchmark::RelaxationDistanceManager rdm_;
 	};
 }
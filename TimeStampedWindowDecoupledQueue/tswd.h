@@ -2,23 +2,33 @@
 #define TSWD_H
 
 #include <utility>
+#include <algorithm>
 #include <vector>
+#include <thread>
+#include <mutex>
 #include <chrono>
 #include <limits>
 #include <optional>
+#include <concepts>
+#include <span>
+#include <iterator>
 #include "random.h"
 #include "ebr.h"
+#include "per_thread_array.h"
+#include "parker.h"
+#include "stopwatch.h"
 #include "relaxation_distance.h"
 
 namespace lf::tswd {
+	template<class T>
 	struct Node {
 		Node() = default;
-		Node(int v) : v{ v } {}
+		Node(T v) : v{ std::move(v) } {}
 
 		Node* volatile next{};
 		uint64_t retire_epoch{};
 		uint64_t time_stamp{};
-		int v{};
+		T v{};
 	};
 
 	struct alignas(std::hardware_destructive_interference_size) Window {
@@ -30,19 +40,53 @@ namespace lf::tswd {
 				&expected, desired);
 		}
 
+		// Moves the time stamp forward to at least ts.
+		void Raise(uint64_t ts) {
+			auto expected = time_stamp;
+			while (expected < ts and not CAS(expected, ts)) {
+				expected = time_stamp;
+			}
+		}
+
 		volatile uint64_t time_stamp{};
 	};
 
+	enum class Registration : uint8_t {
+		kStatic, kDynamic
+	};
+
+	enum class SlotState : uint8_t {
+		kFree, kLive, kOrphaned
+	};
+
+	// Depth set by the adaptive controller, sec seconds after it was enabled.
+	struct DepthSample {
+		double sec;
+		int depth;
+	};
+
+	/* Sub-windows of a NUMA node. The global window spans one sub-window of depth per group,
+	and a node advances its own sub-window through that span without touching the global window,
+	which only advances once a sub-window reaches its end. A sub-window lagging behind the global
+	window is raised to it when read. */
+	struct WindowGroup {
+		Window get;
+		Window put;
+	};
+
+	template<class T>
 	class PartialQueue {
 	public:
-		PartialQueue() : tail_{ new Node }, head_{ tail_ } {}
+		using Node = tswd::Node<T>;
+
+		PartialQueue(NodePool<Node>& pool) : pool_{ pool }, tail_{ pool.New() }, head_{ tail_ } {}
 		~PartialQueue() {
 			while (nullptr != head_->next) {
 				Node* t = head_;
 				head_ = head_->next;
-				delete t;
+				pool_.Destroy(t);
 			}
-			delete head_;
+			pool_.Destroy(head_);
 		}
 
 		void Enq(Node* node, uint64_t put_ts) {
@@ -52,32 +96,120 @@ namespace lf::tswd {
 			tail_ = node;
 		}
 
-		std::pair<std::optional<int>, Node*> TryDeq(EBR<Node>& ebr, int depth,
-			uint64_t get_ts, benchmark::RelaxationDistanceManager& rdm) {
+		// Links a pre-built chain with a single tail update.
+		void Enq(Node* first, Node* last, uint64_t put_ts) {
+			auto time_stamp = std::max(put_ts, tail_->time_stamp);
+			for (auto node = first; nullptr != node; node = node->next) {
+				node->time_stamp = ++time_stamp;
+			}
+			tail_->next = first;
+			tail_ = last;
+		}
+
+		/* Runs as thread id. The head is protected in slot hazard and the first node in slot first_hazard,
+		so that the empty check can read the returned head later in the same operation. */
+		template<class Reclaimer, class Instrumentation>
+		std::pair<std::optional<T>, Node*> TryDeq(Reclaimer& reclaimer, int id, int hazard, int first_hazard,
+			int depth, uint64_t get_ts, Instrumentation& rdm) {
 			while (true) {
-				auto loc_head = head_;
-				auto first = loc_head->next;
+				auto loc_head = reclaimer.Protect(hazard, head_, id);
+				auto first = reclaimer.Protect(first_hazard, loc_head->next, id);
 				if (nullptr == first) {
 					return std::make_pair(std::nullopt, loc_head); // pq is empty
 				}
+				if (loc_head != head_) {
+					continue; // first may have been retired
+				}
 				if (first->time_stamp > get_ts + depth) {
 					return std::make_pair(std::nullopt, nullptr); // retry required
 				}
-				auto value = first->v;
-				rdm.LockDeq();
 				if (true == CAS(head_, loc_head, first)) {
-					rdm.Deq(first);
-					rdm.UnlockDeq();
-					ebr.Retire(loc_head);
-					return std::make_pair(value, nullptr);
+					rdm.Deq(first, this);
+
+					// Only the winner of the CAS owns the payload, so it can be moved out.
+					std::optional<T> value{ std::move(first->v) };
+					reclaimer.Retire(loc_head, id);
+					return std::make_pair(std::move(value), nullptr);
+				}
+			}
+		}
+
+		/* Claims the run of consecutive nodes lying within the window with one CAS.
+		The walk protects nodes alternately in slots first_hazard and first_hazard + 1,
+		and only the last node needs protection once the CAS has detached the run. */
+		template<class Reclaimer, class Instrumentation, class OutputIt>
+		std::pair<size_t, Node*> TryDeq(Reclaimer& reclaimer, int id, int hazard, int first_hazard, int depth,
+			uint64_t get_ts, Instrumentation& rdm, OutputIt& out, size_t max) {
+			while (true) {
+				auto loc_head = reclaimer.Protect(hazard, head_, id);
+				auto first = reclaimer.Protect(first_hazard, loc_head->next, id);
+				if (nullptr == first) {
+					return std::make_pair(0, loc_head); // pq is empty
+				}
+				if (loc_head != head_) {
+					continue; // first may have been retired
+				}
+				if (first->time_stamp > get_ts + depth) {
+					return std::make_pair(0, nullptr); // retry required
+				}
+
+				auto last = first;
+				auto last_hazard = first_hazard;
+				size_t cnt{ 1 };
+				while (cnt < max) {
+					auto next_hazard = first_hazard == last_hazard ? first_hazard + 1 : first_hazard;
+					auto next = reclaimer.Protect(next_hazard, last->next, id);
+					if (nullptr == next or loc_head != head_ or next->time_stamp > get_ts + depth) {
+						break;
+					}
+					last = next;
+					last_hazard = next_hazard;
+					cnt += 1;
+				}
+
+				if (true == CAS(head_, loc_head, last)) {
+					auto node = loc_head;
+					for (size_t i = 0; i < cnt; ++i) {
+						node = node->next;
+						rdm.Deq(node, this);
+					}
+
+					node = loc_head;
+					for (size_t i = 0; i < cnt; ++i) {
+						auto next = node->next;
+						*out = std::move(next->v);
+						++out;
+						reclaimer.Retire(node, id);
+						node = next;
+					}
+					return std::make_pair(cnt, nullptr);
 				}
-				rdm.UnlockDeq();
 			}
 		}
 
 		auto GetTailTimeStamp() const {
 			return tail_->time_stamp;
 		}
+
+		// Must be called inside an operation of the reclaimer. The head is protected in slot hazard of thread id.
+		template<class Reclaimer>
+		bool IsEmpty(Reclaimer& reclaimer, int id, int hazard) {
+			return nullptr == reclaimer.Protect(hazard, head_, id)->next;
+		}
+
+		// Only the owner reads the size. A stale count of dequeued nodes only overestimates it.
+		uint64_t GetSize() const {
+			return num_enq_ - num_deq_;
+		}
+
+		void AddNumEnq(uint64_t num) {
+			num_enq_ += num;
+		}
+
+		void AddNumDeq(uint64_t num) {
+			reinterpret_cast<volatile std::atomic<uint64_t>*>(&num_deq_)->fetch_add(
+				num, std::memory_order_relaxed);
+		}
 	private:
 		bool CAS(Node* volatile& trg, Node* expected, Node* desired) {
 			return std::atomic_compare_exchange_strong(
@@ -85,94 +217,682 @@ namespace lf::tswd {
 				&expected, desired);
 		}
 
+		NodePool<Node>& pool_;
 		alignas(std::hardware_destructive_interference_size) Node* tail_;
+		uint64_t num_enq_{};
 		alignas(std::hardware_destructive_interference_size) Node* volatile head_;
+		volatile uint64_t num_deq_{};
 	};
 
+	/* Reclaimer is EBR, HazardPointer or HazardEra.
+	Instrumentation is benchmark::RelaxationDistanceManager when the relaxation distance is measured. */
+	template<class T = int, template<class> class Reclaimer = EBR,
+		class Instrumentation = benchmark::NullRelaxationDistanceManager>
+		requires std::movable<T> and std::default_initializable<T>
 	class TSWD {
 	public:
-		TSWD(int num_thread, int depth)
-			: depth_{ depth }, queues_(num_thread), ebr_{ num_thread } {}
+		using Node = tswd::Node<T>;
+
+		/* Runs the operations of a thread on its slot without looking up the thread ID each time.
+		A handle from Register() owns the slot of a dynamic TSWD and must be destroyed by the thread that registered. */
+		class Handle {
+		public:
+			Handle(TSWD& queue, int slot, bool owns_slot = true)
+				: queue_{ &queue }, slot_{ slot }, owns_slot_{ owns_slot } {}
+			~Handle() {
+				if (nullptr != queue_ and owns_slot_) {
+					queue_->Unregister(slot_);
+				}
+			}
+			Handle(const Handle&) = delete;
+			Handle(Handle&& other) noexcept
+				: queue_{ std::exchange(other.queue_, nullptr) }, slot_{ other.slot_ }, owns_slot_{ other.owns_slot_ } {}
+			Handle& operator=(const Handle&) = delete;
+			Handle& operator=(Handle&&) = delete;
+
+			int GetSlot() const {
+				return slot_;
+			}
+
+			void Enq(T v) {
+				queue_->Enq(slot_, std::move(v));
+			}
+
+			bool TryEnq(T&& v) {
+				return queue_->TryEnq(slot_, std::move(v));
+			}
+
+			std::optional<T> Deq() {
+				return queue_->Deq(slot_);
+			}
+
+			template<class Rep, class Period>
+			std::optional<T> DeqWait(std::chrono::duration<Rep, Period> timeout) {
+				return queue_->DeqWait(slot_, timeout);
+			}
+
+			void EnqBatch(std::span<T> values) {
+				queue_->EnqBatch(slot_, values);
+			}
+
+			template<class OutputIt> requires std::output_iterator<OutputIt, T>
+			size_t DeqBatch(OutputIt out, size_t max) {
+				return queue_->DeqBatch(slot_, out, max);
+			}
+
+		private:
+			TSWD* queue_;
+			int slot_;
+			bool owns_slot_;
+		};
+
+		TSWD(int num_thread, int depth, size_t capacity = 0,
+			Registration registration = Registration::kStatic)
+			: TSWD(num_thread, depth, std::vector<int>(num_thread), capacity, registration) {}
+		// In NUMA mode, nodes[thread id] gives the node each thread runs on, and dequeuers scan their own node first.
+		TSWD(int num_thread, int depth, std::vector<int> nodes, size_t capacity = 0,
+			Registration registration = Registration::kStatic)
+			: depth_{ depth }, queue_capacity_{ (capacity + num_thread - 1) / num_thread }
+			, nodes_{ std::move(nodes) }
+			, groups_(*std::max_element(nodes_.begin(), nodes_.end()) + 1)
+			, pool_{ num_thread }, reclaimer_{ num_thread, pool_, num_thread + 2 }
+			, old_heads_{ num_thread, static_cast<size_t>(num_thread) }
+			, scan_orders_{ num_thread, static_cast<size_t>(num_thread) }
+			, scan_states_{ num_thread, 1 }, depth_stats_{ num_thread, 1 }, slots_(num_thread) {
+			queues_.reserve(num_thread);
+			for (int i = 0; i < num_thread; ++i) {
+				queues_.emplace_back(pool_);
+			}
+
+			auto state = Registration::kStatic == registration ? SlotState::kLive : SlotState::kFree;
+			for (auto& slot : slots_) {
+				slot.store(state, std::memory_order_relaxed);
+			}
+			for (int id = 0; id < num_thread; ++id) {
+				BuildScanOrder(id);
+			}
+		}
+
+		/* With Registration::kDynamic, num_thread is the number of slots and threads take one here.
+		Takes a slot for the calling thread and assigns it as the thread ID.
+		Orphaned slots on the node are adopted first, then free slots on the node, then any slot.
+		The partial queue of a departed thread goes to the next thread that registers,
+		or its slot is released once dequeuers drain it. */
+		Handle Register(int node = 0) {
+			std::lock_guard lock{ registration_mutex_ };
+
+			auto slot = FindSlot(node);
+			if (slot < 0) {
+				compat::Print("[Error] No free thread slot.\n");
+				std::exit(getchar());
+			}
+
+			slots_[slot].store(SlotState::kLive, std::memory_order_relaxed);
+			version_.fetch_add(1, std::memory_order_release);
+
+			MyThreadID::Set(slot);
+			reclaimer_.Register();
+			return Handle{ *this, slot };
+		}
+
+		// A handle on the slot of the calling thread, which keeps the slot when the handle is destroyed.
+		Handle GetHandle() {
+			return Handle{ *this, MyThreadID::Get(), false };
+		}
 
 		void CheckRelaxationDistance() {
 			rdm_.CheckRelaxationDistance();
 		}
 
+		/* Nodes of different groups are only ordered by the global window, so the bound is that of a single
+		window spanning the sub-windows of every group. With the adaptive depth, it is that of the largest
+		depth the dequeuers may choose. */
+		uint64_t GetRelaxationBound() const {
+			auto depth = is_adaptive_ ? max_depth_ : static_cast<int>(depth_);
+			return static_cast<uint64_t>(queues_.size() - 1) * (GetSpan(depth) + 1);
+		}
+
+		void CheckRelaxationBound(uint64_t bound, uint64_t tolerance) {
+			rdm_.CheckRelaxationBound(bound, tolerance);
+		}
+
 		auto GetRelaxationDistance() {
 			return rdm_.GetRelaxationDistance();
 		}
 
-		void Enq(int v) {
-			auto node = new Node{ v };
+		auto GetNumAllocation() const {
+			return pool_.GetNumAllocation();
+		}
 
-			/* Unless a dequeue occurs when the queue is empty,
-			using the moment of reading the time-stamp of window put
-			as the linearization point does not affect linearizability. */
-			rdm_.LockEnq();
-			auto put_ts = window_put_.time_stamp;
-			rdm_.Enq(node);
-			rdm_.UnlockEnq();
+		/* Lets the dequeuers adjust the depth between 1 and the largest depth whose
+		relaxation bound (num_thread - 1) * (num_group * depth + 1) does not exceed max_relaxation_bound.
+		Every kAdaptInterval dequeues, a dequeuer doubles the depth under contention or halves it
+		when the window is rarely exhausted. Must be called before the queue is shared. */
+		void EnableAdaptiveDepth(uint64_t max_relaxation_bound) {
+			auto num_other = std::max<uint64_t>(queues_.size() - 1, 1);
+			auto max_span = std::max<uint64_t>(max_relaxation_bound / num_other, 2) - 1;
+			max_depth_ = static_cast<int>(std::max<uint64_t>(max_span / groups_.size(), 1));
+			depth_ = std::min(static_cast<int>(depth_), max_depth_);
+			is_adaptive_ = true;
+			depth_trajectory_.assign(kMaxNumDepthSample, DepthSample{});
+			num_depth_sample_.store(0, std::memory_order_relaxed);
+			depth_stopwatch_.Start();
+			RecordDepth(depth_);
+		}
+
+		std::span<const DepthSample> GetDepthTrajectory() const {
+			auto size = std::min(num_depth_sample_.load(std::memory_order_acquire), kMaxNumDepthSample);
+			return std::span<const DepthSample>{ depth_trajectory_.data(), size };
+		}
 
-			auto& pq = queues_[MyThreadID::Get()];
+		int GetDepth() const {
+			return depth_;
+		}
 
-			if (pq.GetTailTimeStamp() == put_ts + depth_) {
-				window_put_.CAS(put_ts, put_ts + depth_);
+		// Read while other threads run, so the count is approximate.
+		uint64_t GetNumUnreclaimed() const {
+			return reclaimer_.GetNumUnreclaimed();
+		}
+
+		auto GetPeakNumRetired() const {
+			return reclaimer_.GetPeakNumRetired();
+		}
+
+		// Holds an operation open until resume is set, as a dequeuer preempted inside Deq would.
+		void Stall(const std::atomic<bool>& resume) {
+			auto id = MyThreadID::Get();
+			reclaimer_.StartOp(id);
+			queues_[id].IsEmpty(reclaimer_, id, id);
+			while (not resume.load(std::memory_order_acquire)) {
+				std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
 			}
-			pq.Enq(node, put_ts);
+			reclaimer_.EndOp(id);
+		}
+
+		// With a capacity, blocks until the own partial queue has room.
+		void Enq(T v) {
+			Enq(MyThreadID::Get(), std::move(v));
+		}
+
+		// Returns false and leaves v untouched when the own partial queue is full.
+		bool TryEnq(T&& v) {
+			return TryEnq(MyThreadID::Get(), std::move(v));
+		}
+
+		std::optional<T> Deq() {
+			return Deq(MyThreadID::Get());
 		}
 
-		std::optional<int> Deq() {
-			std::vector<Node*> old_heads(queues_.size());
-			size_t id = MyThreadID::Get();
+		// Spins for a short while, then parks until an element is enqueued or the timeout expires.
+		template<class Rep, class Period>
+		std::optional<T> DeqWait(std::chrono::duration<Rep, Period> timeout) {
+			return DeqWait(MyThreadID::Get(), timeout);
+		}
 
-			ebr_.StartOp();
+		// Enqueues the values as a chain, splitting it only where the window put must advance.
+		// With a capacity, the values are enqueued one by one, blocking while the own partial queue is full.
+		void EnqBatch(std::span<T> values) {
+			EnqBatch(MyThreadID::Get(), values);
+		}
+
+		// Dequeues up to max values from a single partial queue and returns the number written to out.
+		template<class OutputIt> requires std::output_iterator<OutputIt, T>
+		size_t DeqBatch(OutputIt out, size_t max) {
+			return DeqBatch(MyThreadID::Get(), out, max);
+		}
+	private:
+		static constexpr std::chrono::microseconds kSpinDuration{ 50 };
+		static constexpr uint64_t kAdaptInterval{ 4096 };
+		static constexpr double kGrowThreshold{ 0.25 };
+		static constexpr double kShrinkThreshold{ 0.02 };
+		static constexpr size_t kMaxNumDepthSample{ 256 };
+
+		// The operations of thread id, which the public ones look up once and a handle keeps.
+		void Enq(int id, T v) {
+			if (0 != queue_capacity_) {
+				while (queues_[id].GetSize() >= queue_capacity_) {
+					std::this_thread::yield();
+				}
+			}
+			EnqNode(id, NewNode(id, std::move(v)));
+		}
+
+		bool TryEnq(int id, T&& v) {
+			if (0 != queue_capacity_
+				and queues_[id].GetSize() >= queue_capacity_) {
+				return false;
+			}
+			EnqNode(id, NewNode(id, std::move(v)));
+			return true;
+		}
+
+		std::optional<T> Deq(int id) {
+			auto& group = groups_[nodes_[id]];
+			auto old_heads = old_heads_[id];
+			auto scan_order = GetScanOrder(id);
+
+			if (is_adaptive_) [[unlikely]] {
+				CountDeq(id);
+			}
+			reclaimer_.StartOp(id);
 			while (true) {
-				int cnt_empty{};
-				auto put_ts = window_put_.time_stamp;
-				auto get_ts = window_get_.time_stamp;
-				for (size_t i = 0; i < queues_.size(); ++i) {
-					auto& pq = queues_[id];
-					auto [value, old_head] = pq.TryDeq(ebr_, depth_, get_ts, rdm_);
+				size_t cnt_empty{};
+				int depth = depth_;
+				auto put_ts = GetGlobal(window_put_, group, &WindowGroup::put).time_stamp;
+				auto get = GetSubWindow(window_get_, group, &WindowGroup::get, depth);
+				for (auto qid : scan_order) {
+					auto& pq = queues_[qid];
+					auto [value, old_head] = pq.TryDeq(reclaimer_, id, qid, GetFirstHazard(), get.depth, get.ts, rdm_);
 					if (nullptr != old_head) {
-						old_heads[id] = old_head;
+						old_heads[qid] = old_head;
 						cnt_empty += 1;
+						if (SlotState::kOrphaned == slots_[qid].load(std::memory_order_relaxed)) [[unlikely]] {
+							ReleaseOrphan(id, qid);
+						}
 					} else if (value.has_value()) {
-						ebr_.EndOp();
+						if (0 != queue_capacity_) {
+							pq.AddNumDeq(1);
+						}
+						reclaimer_.EndOp(id);
 						return value;
 					}
-					id = (id + 1) % queues_.size();
 				}
 
-				if (queues_.size() == cnt_empty) {
+				if (scan_order.size() == cnt_empty) {
 					bool is_empty{ true };
-					for (size_t i = 1; i < queues_.size(); ++i) {
-						id = (i + MyThreadID::Get()) % queues_.size();
-						auto next = old_heads[id]->next;
+					for (auto qid : scan_order.subspan(1)) {
+						auto next = old_heads[qid]->next;
 						if (nullptr != next) {
 							is_empty = false;
 							break;
 						}
 					}
 					if (is_empty) {
-						ebr_.EndOp();
+						reclaimer_.EndOp(id);
 						return std::nullopt;
 					}
+				}
+
+				bool has_advanced{ true };
+				if (CanAdvanceSubWindow(get, depth) or get.global_ts < put_ts) {
+					has_advanced = Advance(window_get_, group, &WindowGroup::get, get, depth);
+				}
+				if (is_adaptive_) [[unlikely]] {
+					CountRetry(id, has_advanced);
+				}
+			}
+		}
+
+		template<class Rep, class Period>
+		std::optional<T> DeqWait(int id, std::chrono::duration<Rep, Period> timeout) {
+			using Clock = std::chrono::steady_clock;
+			auto now = Clock::now();
+			auto deadline = now + timeout;
+			auto spin_deadline = std::min(deadline, now + kSpinDuration);
+
+			while (now < spin_deadline) {
+				auto value = Deq(id);
+				if (value.has_value()) {
+					return value;
+				}
+				now = Clock::now();
+			}
+
+			while (true) {
+				auto signal = parker_.Prepare();
+				auto value = Deq(id);
+				now = Clock::now();
+				if (value.has_value() or now >= deadline) {
+					parker_.Cancel();
+					return value;
+				}
+				parker_.Park(signal, std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now));
+			}
+		}
+
+		void EnqBatch(int id, std::span<T> values) {
+			if (values.empty()) {
+				return;
+			}
+
+			if (0 != queue_capacity_) {
+				for (auto& v : values) {
+					Enq(id, std::move(v));
+				}
+				return;
+			}
+
+			Node* first{};
+			Node* last{};
+			for (auto& v : values) {
+				auto node = NewNode(id, std::move(v));
+				if (nullptr == first) {
+					first = node;
 				} else {
-					id = MyThreadID::Get();
+					last->next = node;
+				}
+				last = node;
+			}
+
+			auto& group = groups_[nodes_[id]];
+			auto& pq = queues_[id];
+
+			while (nullptr != first) {
+				int depth = depth_;
+				auto stamp = rdm_.Stamp();
+				auto put = GetSubWindow(window_put_, group, &WindowGroup::put, depth);
+				auto tail_ts = pq.GetTailTimeStamp();
+				// The tail may lie above the window after the adaptive controller shrank the depth.
+				if (tail_ts >= put.ts + put.depth) {
+					Advance(window_put_, group, &WindowGroup::put, put, depth);
+					continue;
 				}
+				auto room = put.ts + put.depth - std::max(put.ts, tail_ts);
 
-				if (get_ts < put_ts) {
-					window_get_.CAS(get_ts, get_ts + depth_);
+				auto chunk_last = first;
+				rdm_.Enq(chunk_last, stamp);
+				for (uint64_t i = 1; i < room and nullptr != chunk_last->next; ++i) {
+					chunk_last = chunk_last->next;
+					rdm_.Enq(chunk_last, stamp);
 				}
+
+				auto next_first = chunk_last->next;
+				chunk_last->next = nullptr;
+
+				pq.Enq(first, chunk_last, put.ts);
+				first = next_first;
 			}
+			parker_.Unpark(static_cast<int>(values.size()));
 		}
-	private:
-		int depth_;
-		std::vector<PartialQueue> queues_;
-		EBR<Node> ebr_;
+
+		template<class OutputIt> requires std::output_iterator<OutputIt, T>
+		size_t DeqBatch(int id, OutputIt out, size_t max) {
+			if (0 == max) {
+				return 0;
+			}
+
+			auto& group = groups_[nodes_[id]];
+			auto old_heads = old_heads_[id];
+			auto scan_order = GetScanOrder(id);
+
+			if (is_adaptive_) [[unlikely]] {
+				CountDeq(id);
+			}
+			reclaimer_.StartOp(id);
+			while (true) {
+				size_t cnt_empty{};
+				int depth = depth_;
+				auto put_ts = GetGlobal(window_put_, group, &WindowGroup::put).time_stamp;
+				auto get = GetSubWindow(window_get_, group, &WindowGroup::get, depth);
+				for (auto qid : scan_order) {
+					auto& pq = queues_[qid];
+					auto [cnt, old_head] = pq.TryDeq(reclaimer_, id, qid, GetFirstHazard(), get.depth, get.ts, rdm_, out, max);
+					if (nullptr != old_head) {
+						old_heads[qid] = old_head;
+						cnt_empty += 1;
+						if (SlotState::kOrphaned == slots_[qid].load(std::memory_order_relaxed)) [[unlikely]] {
+							ReleaseOrphan(id, qid);
+						}
+					} else if (cnt > 0) {
+						if (0 != queue_capacity_) {
+							pq.AddNumDeq(cnt);
+						}
+						reclaimer_.EndOp(id);
+						return cnt;
+					}
+				}
+
+				if (scan_order.size() == cnt_empty) {
+					bool is_empty{ true };
+					for (auto qid : scan_order.subspan(1)) {
+						auto next = old_heads[qid]->next;
+						if (nullptr != next) {
+							is_empty = false;
+							break;
+						}
+					}
+					if (is_empty) {
+						reclaimer_.EndOp(id);
+						return 0;
+					}
+				}
+
+				bool has_advanced{ true };
+				if (CanAdvanceSubWindow(get, depth) or get.global_ts < put_ts) {
+					has_advanced = Advance(window_get_, group, &WindowGroup::get, get, depth);
+				}
+				if (is_adaptive_) [[unlikely]] {
+					CountRetry(id, has_advanced);
+				}
+			}
+		}
+
+		Node* NewNode(int id, T&& v) {
+			auto node = pool_.NewFor(id, std::move(v));
+			reclaimer_.OnNew(node);
+			return node;
+		}
+
+		int GetFirstHazard() const {
+			return static_cast<int>(queues_.size());
+		}
+
+		void EnqNode(int id, Node* node) {
+			/* Unless a dequeue occurs when the queue is empty,
+			using the moment of reading the time-stamp of window put
+			as the linearization point does not affect linearizability. */
+			auto& group = groups_[nodes_[id]];
+
+			int depth = depth_;
+			auto stamp = rdm_.Stamp();
+			auto put = GetSubWindow(window_put_, group, &WindowGroup::put, depth);
+			rdm_.Enq(node, stamp);
+
+			auto& pq = queues_[id];
+			if (pq.GetTailTimeStamp() >= put.ts + put.depth) {
+				Advance(window_put_, group, &WindowGroup::put, put, depth);
+			}
+			pq.Enq(node, put.ts);
+			if (0 != queue_capacity_) {
+				pq.AddNumEnq(1);
+			}
+			parker_.Unpark();
+		}
+
+		struct ScanState {
+			uint64_t version{};
+			size_t size{};
+		};
+
+		void Unregister(int slot) {
+			reclaimer_.Unregister();
+
+			std::lock_guard lock{ registration_mutex_ };
+			slots_[slot].store(SlotState::kOrphaned, std::memory_order_relaxed);
+			version_.fetch_add(1, std::memory_order_release);
+			MyThreadID::Reset();
+		}
+
+		int FindSlot(int node) const {
+			for (auto state : { SlotState::kOrphaned, SlotState::kFree }) {
+				for (size_t slot = 0; slot < slots_.size(); ++slot) {
+					if (state == slots_[slot].load(std::memory_order_relaxed) and node == nodes_[slot]) {
+						return static_cast<int>(slot);
+					}
+				}
+			}
+			for (auto state : { SlotState::kOrphaned, SlotState::kFree }) {
+				for (size_t slot = 0; slot < slots_.size(); ++slot) {
+					if (state == slots_[slot].load(std::memory_order_relaxed)) {
+						return static_cast<int>(slot);
+					}
+				}
+			}
+			return -1;
+		}
+
+		// Called inside an operation of the reclaimer by dequeuer id that found the orphaned partial queue empty.
+		void ReleaseOrphan(int id, int slot) {
+			std::unique_lock lock{ registration_mutex_, std::try_to_lock };
+			if (not lock.owns_lock()
+				or SlotState::kOrphaned != slots_[slot].load(std::memory_order_relaxed)
+				or not queues_[slot].IsEmpty(reclaimer_, id, slot)) {
+				return;
+			}
+			slots_[slot].store(SlotState::kFree, std::memory_order_relaxed);
+			version_.fetch_add(1, std::memory_order_release);
+		}
+
+		std::span<int> GetScanOrder(int id) {
+			auto& scan_state = scan_states_[id].front();
+			auto version = version_.load(std::memory_order_acquire);
+			if (version != scan_state.version) [[unlikely]] {
+				scan_state.version = version;
+				BuildScanOrder(id);
+			}
+			return scan_orders_[id].first(scan_state.size);
+		}
+
+		// Own queue first, then the rest of the own group, then the other groups. Free slots are skipped.
+		void BuildScanOrder(int id) {
+			auto scan_order = scan_orders_[id];
+			auto& size = scan_states_[id].front().size;
+			auto num_slot = static_cast<int>(slots_.size());
+
+			size = 0;
+			for (int i = 0; i < num_slot; ++i) {
+				auto qid = (id + i) % num_slot;
+				if (0 == i or SlotState::kFree != slots_[qid].load(std::memory_order_relaxed)) {
+					scan_order[size++] = qid;
+				}
+			}
+			std::stable_partition(scan_order.begin(), scan_order.begin() + size, [&](int qid) {
+				return nodes_[qid] == nodes_[id];
+				});
+		}
+
+		// Nodes are stamped in (ts, ts + depth], which ends no later than the span of the global window.
+		struct SubWindow {
+			uint64_t global_ts;
+			uint64_t ts;
+			int depth;
+		};
+
+		uint64_t GetSpan(int depth) const {
+			return static_cast<uint64_t>(groups_.size()) * depth;
+		}
+
+		// With a single group, its windows are the global windows.
+		Window& GetGlobal(Window& global, WindowGroup& group, Window WindowGroup::* window) {
+			return 1 == groups_.size() ? group.*window : global;
+		}
+
+		SubWindow GetSubWindow(Window& global, WindowGroup& group, Window WindowGroup::* window, int depth) {
+			auto& sub = group.*window;
+			uint64_t ts = sub.time_stamp;
+			if (1 == groups_.size()) {
+				return SubWindow{ ts, ts, depth };
+			}
+
+			uint64_t global_ts = global.time_stamp;
+			if (ts < global_ts) {
+				sub.Raise(global_ts);
+				ts = global_ts;
+			}
+			// The end lies below the sub-window once the adaptive controller has shrunk the depth.
+			auto end = global_ts + GetSpan(depth);
+			return SubWindow{ global_ts, ts, ts < end ? static_cast<int>(std::min(ts + depth, end) - ts) : 0 };
+		}
+
+		bool CanAdvanceSubWindow(const SubWindow& sub, int depth) const {
+			return sub.ts + depth < sub.global_ts + GetSpan(depth);
+		}
+
+		// Returns false if the CAS failed.
+		bool Advance(Window& global, WindowGroup& group, Window WindowGroup::* window,
+			const SubWindow& sub, int depth) {
+			if (CanAdvanceSubWindow(sub, depth)) {
+				return (group.*window).CAS(sub.ts, sub.ts + depth);
+			}
+			return GetGlobal(global, group, window).CAS(sub.global_ts, sub.global_ts + GetSpan(depth));
+		}
+
+		struct DepthStats {
+			uint64_t num_deq{};
+			uint64_t num_retry{};
+			uint64_t num_cas_failure{};
+		};
+
+		void CountDeq(int id) {
+			auto& stats = depth_stats_[id].front();
+			stats.num_deq += 1;
+			if (kAdaptInterval == stats.num_deq) {
+				AdaptDepth(stats);
+				stats = DepthStats{};
+			}
+		}
+
+		void CountRetry(int id, bool has_advanced) {
+			auto& stats = depth_stats_[id].front();
+			stats.num_retry += 1;
+			if (not has_advanced) {
+				stats.num_cas_failure += 1;
+			}
+		}
+
+		/* A retry round means the window get was exhausted before an element was found,
+		and a failed CAS means another dequeuer exhausted it at the same time.
+		Nodes stamped before a shrink may lie above the new window; enqueuers keep advancing
+		the window put until their tails fit again, so the bound holds once the windows have caught up. */
+		void AdaptDepth(const DepthStats& stats) {
+			int depth = depth_;
+			auto contention = static_cast<double>(stats.num_retry + stats.num_cas_failure) / stats.num_deq;
+			auto new_depth = depth;
+			if (contention > kGrowThreshold) {
+				new_depth = std::min(depth * 2, max_depth_);
+			} else if (contention < kShrinkThreshold) {
+				new_depth = std::max(depth / 2, 1);
+			}
+
+			if (new_depth != depth and std::atomic_compare_exchange_strong(
+				reinterpret_cast<volatile std::atomic<int>*>(&depth_), &depth, new_depth)) {
+				RecordDepth(new_depth);
+			}
+		}
+
+		void RecordDepth(int depth) {
+			auto index = num_depth_sample_.fetch_add(1, std::memory_order_acq_rel);
+			if (index < kMaxNumDepthSample) {
+				depth_trajectory_[index] = DepthSample{ depth_stopwatch_.GetDuration(), depth };
+			}
+		}
+
+		volatile int depth_;
+		int max_depth_{};
+		bool is_adaptive_{};
+		// The capacity split evenly over the partial queues, each sized by its owner from its counts. 0 is unbounded.
+		size_t queue_capacity_;
+		std::vector<int> nodes_;
+		std::vector<WindowGroup> groups_;
+		NodePool<Node> pool_;
+		std::vector<PartialQueue<T>> queues_;
+		// Slot i protects the head of partial queue i, and the two slots after them the nodes behind a head.
+		Reclaimer<Node> reclaimer_;
+		PerThreadArray<Node*> old_heads_;
+		PerThreadArray<int> scan_orders_;
+		PerThreadArray<ScanState> scan_states_;
+		PerThreadArray<DepthStats> depth_stats_;
+		// Dequeuers only scan slots that are not free.
+		std::vector<std::atomic<SlotState>> slots_;
+		std::mutex registration_mutex_;
+		alignas(std::hardware_destructive_interference_size) std::atomic<uint64_t> version_{};
 		Window window_get_;
 		Window window_put_;
-		benchmark::RelaxationDistanceManager rdm_;
+		Parker parker_;
+		std::vector<DepthSample> depth_trajectory_;
+		std::atomic<size_t> num_depth_sample_{};
+		Stopwatch depth_stopwatch_;
+		[[no_unique_address]] Instrumentation rdm_;
 	};
 }
 
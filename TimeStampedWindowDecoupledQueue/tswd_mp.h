@@ -0,0 +1,208 @@
+#ifndef TSWD_MP_H
+#define TSWD_MP_H
+
+#include <utility>
+#include <vector>
+#include <optional>
+#include <concepts>
+#include "ebr.h"
+#include "per_thread_array.h"
+#include "relaxation_distance.h"
+#include "tswd.h"
+
+namespace lf::tswd_mp {
+	using tswd::Window;
+
+	/* Multi-producer partial queue in the style of Michael and Scott.
+	A node is stamped from the tail it is linked after, so time stamps still increase along the queue.
+	Both operations must run inside an EBR operation, since the tail may be retired by a dequeuer. */
+	template<class T>
+	class PartialQueue {
+	public:
+		using Node = tswd::Node<T>;
+
+		PartialQueue(NodePool<Node>& pool) : pool_{ pool }, tail_{ pool.New() }, head_{ tail_ } {}
+		~PartialQueue() {
+			while (nullptr != head_->next) {
+				Node* t = head_;
+				head_ = head_->next;
+				pool_.Destroy(t);
+			}
+			pool_.Destroy(head_);
+		}
+
+		/* Every attempt stamps the log before it reads the window put, as the enqueue of TSWD does,
+		so a thread preempted before its CAS links a node no older than the log says.
+		Advances the window put when the tail has reached its top. */
+		template<class Instrumentation>
+		void Enq(Node* node, Window& window_put, int depth, Instrumentation& rdm) {
+			while (true) {
+				auto stamp = rdm.Stamp();
+				auto put_ts = window_put.time_stamp;
+				auto tail = tail_;
+				auto next = tail->next;
+				if (nullptr != next) {
+					CAS(tail_, tail, next);
+					continue;
+				}
+				if (tail->time_stamp >= put_ts + depth) {
+					window_put.CAS(put_ts, put_ts + depth);
+					continue;
+				}
+
+				node->time_stamp = std::max(put_ts, tail->time_stamp) + 1;
+				if (true == CAS(tail->next, nullptr, node)) {
+					rdm.Enq(node, stamp);
+					CAS(tail_, tail, node);
+					return;
+				}
+			}
+		}
+
+		template<class Instrumentation>
+		std::pair<std::optional<T>, Node*> TryDeq(EBR<Node>& ebr, int depth,
+			uint64_t get_ts, Instrumentation& rdm) {
+			while (true) {
+				auto loc_head = head_;
+				auto first = loc_head->next;
+				if (nullptr == first) {
+					return std::make_pair(std::nullopt, loc_head); // pq is empty
+				}
+				if (first->time_stamp > get_ts + depth) {
+					return std::make_pair(std::nullopt, nullptr); // retry required
+				}
+				if (loc_head == tail_) {
+					// The tail must not point to a node that is about to be retired.
+					CAS(tail_, loc_head, first);
+				}
+				if (true == CAS(head_, loc_head, first)) {
+					rdm.Deq(first, this);
+
+					std::optional<T> value{ std::move(first->v) };
+					ebr.Retire(loc_head);
+					return std::make_pair(std::move(value), nullptr);
+				}
+			}
+		}
+
+	private:
+		bool CAS(Node* volatile& trg, Node* expected, Node* desired) {
+			return std::atomic_compare_exchange_strong(
+				reinterpret_cast<volatile std::atomic<Node*>*>(&trg),
+				&expected, desired);
+		}
+
+		NodePool<Node>& pool_;
+		alignas(std::hardware_destructive_interference_size) Node* volatile tail_;
+		alignas(std::hardware_destructive_interference_size) Node* volatile head_;
+	};
+
+	/* TSWD whose width is decoupled from the number of threads.
+	Each thread enqueues into partial queue (thread id % width), which may be shared with other threads.
+	The relaxation bound becomes (width - 1) * (depth + 1). */
+	template<class T = int, class Instrumentation = benchmark::NullRelaxationDistanceManager>
+		requires std::movable<T> and std::default_initializable<T>
+	class TSWDMP {
+	public:
+		using Node = tswd::Node<T>;
+
+		TSWDMP(int num_queue, int num_thread, int depth)
+			: depth_{ depth }, pool_{ num_thread }, ebr_{ num_thread, pool_ }
+			, old_heads_{ num_thread, static_cast<size_t>(num_queue) } {
+			queues_.reserve(num_queue);
+			for (int i = 0; i < num_queue; ++i) {
+				queues_.emplace_back(pool_);
+			}
+		}
+
+		void CheckRelaxationDistance() {
+			rdm_.CheckRelaxationDistance();
+		}
+
+		uint64_t GetRelaxationBound() const {
+			return static_cast<uint64_t>(queues_.size() - 1) * (depth_ + 1);
+		}
+
+		void CheckRelaxationBound(uint64_t bound, uint64_t tolerance) {
+			rdm_.CheckRelaxationBound(bound, tolerance);
+		}
+
+		auto GetRelaxationDistance() {
+			return rdm_.GetRelaxationDistance();
+		}
+
+		auto GetNumAllocation() const {
+			return pool_.GetNumAllocation();
+		}
+
+		auto GetPeakNumRetired() const {
+			return ebr_.GetPeakNumRetired();
+		}
+
+		void Enq(T v) {
+			auto node = pool_.New(std::move(v));
+			auto& pq = queues_[MyThreadID::Get() % queues_.size()];
+
+			ebr_.StartOp();
+			pq.Enq(node, window_put_, depth_, rdm_);
+			ebr_.EndOp();
+		}
+
+		std::optional<T> Deq() {
+			auto old_heads = old_heads_[MyThreadID::Get()];
+			size_t home = MyThreadID::Get() % queues_.size();
+			size_t id = home;
+
+			ebr_.StartOp();
+			while (true) {
+				size_t cnt_empty{};
+				auto put_ts = window_put_.time_stamp;
+				auto get_ts = window_get_.time_stamp;
+				for (size_t i = 0; i < queues_.size(); ++i) {
+					auto [value, old_head] = queues_[id].TryDeq(ebr_, depth_, get_ts, rdm_);
+					if (nullptr != old_head) {
+						old_heads[id] = old_head;
+						cnt_empty += 1;
+					} else if (value.has_value()) {
+						ebr_.EndOp();
+						return value;
+					}
+					id = (id + 1) % queues_.size();
+				}
+
+				if (queues_.size() == cnt_empty) {
+					// Unlike TSWD, the own partial queue is shared and must be checked again as well.
+					bool is_empty{ true };
+					for (size_t i = 0; i < queues_.size(); ++i) {
+						id = (home + i) % queues_.size();
+						if (nullptr != old_heads[id]->next) {
+							is_empty = false;
+							break;
+						}
+					}
+					if (is_empty) {
+						ebr_.EndOp();
+						return std::nullopt;
+					}
+				}
+				id = home;
+
+				if (get_ts < put_ts) {
+					window_get_.CAS(get_ts, get_ts + depth_);
+				}
+			}
+		}
+
+	private:
+		int depth_;
+		NodePool<Node> pool_;
+		std::vector<PartialQueue<T>> queues_;
+		EBR<Node> ebr_;
+		PerThreadArray<Node*> old_heads_;
+		Window window_get_;
+		Window window_put_;
+		[[no_unique_address]] Instrumentation rdm_;
+	};
+}
+
+#endif
\ No newline at end of file
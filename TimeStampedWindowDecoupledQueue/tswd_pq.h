@@ -0,0 +1,246 @@
+#ifndef TSWD_PQ_H
+#define TSWD_PQ_H
+
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <optional>
+#include <concepts>
+#include "my_thread_id.h"
+#include "relaxation_distance.h"
+#include "tswd.h"
+
+namespace lf::tswd_pq {
+	using tswd::Window;
+
+	inline constexpr uint64_t kEmpty{ std::numeric_limits<uint64_t>::max() };
+
+	/* The run_length smallest elements in a sorted run in front of a binary min-heap, guarded by a spin lock.
+	The heap is only used while the run is full. The priorities of the top and of the last element
+	of a full run are published, so that dequeuers check the window without locking. */
+	template<class T>
+	class alignas(std::hardware_destructive_interference_size) PartialHeap {
+	public:
+		PartialHeap() {
+			heap_.reserve(kInitialCapacity);
+		}
+
+		void Init(size_t run_length) {
+			run_length_ = run_length;
+			run_.reserve(run_length);
+		}
+
+		// Returns the published bound after the push.
+		template<class Instrumentation>
+		uint64_t Push(T v, uint64_t priority, Instrumentation& rdm) {
+			Lock();
+			auto stamp = rdm.Stamp();
+			if (run_.size() == run_length_ and priority >= run_.back().priority) {
+				PushHeap(Entry{ priority, std::move(v) });
+			} else {
+				if (run_.size() == run_length_) {
+					PushHeap(std::move(run_.back()));
+					run_.pop_back();
+				}
+				auto it = std::upper_bound(run_.begin(), run_.end(), priority, [](uint64_t p, const Entry& e) {
+					return p < e.priority;
+					});
+				run_.emplace(it, priority, std::move(v));
+			}
+			Publish();
+
+			rdm.Insert(priority, stamp);
+			auto bound = bound_;
+			Unlock();
+			return bound;
+		}
+
+		// Pops the top if its priority does not exceed max_priority. Gives up if the heap is locked.
+		template<class Instrumentation>
+		std::optional<T> TryPop(uint64_t max_priority, Instrumentation& rdm) {
+			if (not TryLock()) {
+				return std::nullopt;
+			}
+			if (run_.empty() or run_.front().priority > max_priority) {
+				Unlock();
+				return std::nullopt;
+			}
+
+			auto entry = std::move(run_.front());
+			run_.erase(run_.begin());
+			if (not heap_.empty()) {
+				std::pop_heap(heap_.begin(), heap_.end(), Compare);
+				run_.push_back(std::move(heap_.back()));
+				heap_.pop_back();
+			}
+			Publish();
+
+			rdm.Remove(entry.priority, this);
+			Unlock();
+			return std::optional<T>{ std::move(entry.v) };
+		}
+
+		uint64_t GetTop() const {
+			return top_;
+		}
+
+		// The priority of the last element of a full run, below which the heap holds fewer than run_length elements.
+		uint64_t GetBound() const {
+			return bound_;
+		}
+
+		uint64_t GetNumAllocation() const {
+			return num_allocation_;
+		}
+
+	private:
+		struct Entry {
+			Entry(uint64_t priority, T v) : priority{ priority }, v{ std::move(v) } {}
+
+			uint64_t priority;
+			T v;
+		};
+
+		static constexpr size_t kInitialCapacity{ 1024 };
+
+		static bool Compare(const Entry& a, const Entry& b) {
+			return a.priority > b.priority;
+		}
+
+		void PushHeap(Entry&& entry) {
+			if (heap_.size() == heap_.capacity()) {
+				num_allocation_ += 1;
+			}
+			heap_.push_back(std::move(entry));
+			std::push_heap(heap_.begin(), heap_.end(), Compare);
+		}
+
+		void Publish() {
+			top_ = run_.empty() ? kEmpty : run_.front().priority;
+			bound_ = run_.size() == run_length_ ? run_.back().priority : kEmpty;
+		}
+
+		void Lock() {
+			while (not TryLock()) {
+				std::this_thread::yield();
+			}
+		}
+
+		bool TryLock() {
+			return not is_locked_.load(std::memory_order_relaxed)
+				and not is_locked_.exchange(true, std::memory_order_acquire);
+		}
+
+		void Unlock() {
+			is_locked_.store(false, std::memory_order_release);
+		}
+
+		std::atomic<bool> is_locked_{};
+		volatile uint64_t top_{ kEmpty };
+		volatile uint64_t bound_{ kEmpty };
+		uint64_t num_allocation_{};
+		size_t run_length_{ 1 };
+		std::vector<Entry> run_;
+		std::vector<Entry> heap_;
+	};
+
+	/* Relaxed priority queue built on the window of TSWD. Smaller priorities are dequeued first.
+	Each thread pushes into its own partial heap, which publishes the priority of its (depth + 1)-th
+	smallest element as its bound. The window get holds a priority at or below every bound, and a dequeuer
+	may pop the top of any heap that lies within it, so every other heap holds at most depth elements
+	with a smaller priority. The rank error is therefore bounded by (num_thread - 1) * depth.
+	When no top lies within the window, the dequeuer raises the window to the smallest bound it saw,
+	and an enqueuer lowers the window to the bound of its heap after a push. */
+	template<class T = int, class Instrumentation = benchmark::NullRelaxationDistanceManager>
+		requires std::movable<T> and std::default_initializable<T>
+	class TSWDPQ {
+	public:
+		TSWDPQ(int num_thread, int depth) : depth_{ static_cast<uint64_t>(depth) }, heaps_(num_thread) {
+			for (auto& heap : heaps_) {
+				heap.Init(depth_ + 1);
+			}
+		}
+
+		void CheckRelaxationDistance() {
+			rdm_.CheckRelaxationDistance();
+		}
+
+		uint64_t GetRelaxationBound() const {
+			return static_cast<uint64_t>(heaps_.size() - 1) * depth_;
+		}
+
+		void CheckRelaxationBound(uint64_t bound, uint64_t tolerance) {
+			rdm_.CheckRelaxationBound(bound, tolerance);
+		}
+
+		auto GetRelaxationDistance() {
+			return rdm_.GetRelaxationDistance();
+		}
+
+		uint64_t GetNumAllocation() const {
+			uint64_t num_allocation{};
+			for (const auto& heap : heaps_) {
+				num_allocation += heap.GetNumAllocation();
+			}
+			return num_allocation;
+		}
+
+		void Enq(T v, uint64_t priority) {
+			auto bound = heaps_[MyThreadID::Get()].Push(std::move(v), priority, rdm_);
+
+			auto get_priority = window_get_.time_stamp;
+			while (bound < get_priority and not window_get_.CAS(get_priority, bound)) {
+				get_priority = window_get_.time_stamp;
+			}
+		}
+
+		// Integral elements are their own priorities.
+		void Enq(T v) requires std::integral<T> {
+			auto priority = static_cast<uint64_t>(v);
+			Enq(std::move(v), priority);
+		}
+
+		std::optional<T> Deq() {
+			auto num_heap = heaps_.size();
+			size_t home = MyThreadID::Get();
+
+			while (true) {
+				auto get_priority = window_get_.time_stamp;
+				auto min_top = kEmpty;
+				auto min_bound = kEmpty;
+				auto id = home;
+				for (size_t i = 0; i < num_heap; ++i) {
+					auto& heap = heaps_[id];
+					if (heap.GetTop() <= get_priority) {
+						auto value = heap.TryPop(get_priority, rdm_);
+						if (value.has_value()) {
+							return value;
+						}
+					}
+					min_top = std::min(min_top, heap.GetTop());
+					min_bound = std::min(min_bound, heap.GetBound());
+					id = (id + 1) % num_heap;
+				}
+
+				if (kEmpty == min_top) {
+					return std::nullopt;
+				}
+				// A bound is never below the top of its heap, so the smallest top lies within the new window.
+				if (min_bound > get_priority) {
+					window_get_.CAS(get_priority, min_bound);
+				}
+			}
+		}
+
+	private:
+		uint64_t depth_;
+		std::vector<PartialHeap<T>> heaps_;
+		Window window_get_;
+		[[no_unique_address]] Instrumentation rdm_;
+	};
+}
+
+#endif
\ No newline at end of file
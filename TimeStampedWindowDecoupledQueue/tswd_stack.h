@@ -0,0 +1,196 @@
+#ifndef TSWD_STACK_H
+#define TSWD_STACK_H
+
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include <optional>
+#include <concepts>
+#include "ebr.h"
+#include "relaxation_distance.h"
+#include "tswd.h"
+
+namespace lf::tswd_stack {
+	using tswd::Window;
+
+	/* Treiber stack whose nodes are stamped in increasing order from the bottom.
+	The owner pushes and any thread pops. Both operations must run inside an EBR operation. */
+	template<class T>
+	class PartialStack {
+	public:
+		using Node = tswd::Node<T>;
+
+		PartialStack(NodePool<Node>& pool) : pool_{ pool } {}
+		~PartialStack() {
+			while (nullptr != top_) {
+				Node* t = top_;
+				top_ = top_->next;
+				pool_.Destroy(t);
+			}
+		}
+
+		// Stamps the node above both the window and the current top. Returns the top stamped over.
+		template<class Instrumentation>
+		uint64_t Push(Node* node, uint64_t window_ts, Instrumentation& rdm) {
+			while (true) {
+				auto top = top_;
+				auto top_ts = nullptr == top ? 0 : top->time_stamp;
+				node->time_stamp = std::max(window_ts, top_ts) + 1;
+				node->next = top;
+
+				auto stamp = rdm.Stamp();
+				if (true == CAS(top_, top, node)) {
+					rdm.Push(node, stamp);
+					return top_ts;
+				}
+			}
+		}
+
+		/* Pops the top if its time stamp is at least min_ts.
+		Returns the top left in place, or nullptr on success or when the stack is empty. */
+		template<class Instrumentation>
+		std::pair<std::optional<T>, Node*> TryPop(EBR<Node>& ebr, uint64_t min_ts,
+			Instrumentation& rdm) {
+			while (true) {
+				auto top = top_;
+				if (nullptr == top) {
+					return std::make_pair(std::nullopt, nullptr); // ps is empty
+				}
+				if (top->time_stamp < min_ts) {
+					return std::make_pair(std::nullopt, top); // outside the window
+				}
+				if (true == CAS(top_, top, top->next)) {
+					rdm.Pop(top, this);
+
+					std::optional<T> value{ std::move(top->v) };
+					ebr.Retire(top);
+					return std::make_pair(std::move(value), nullptr);
+				}
+			}
+		}
+
+		bool IsEmpty() const {
+			return nullptr == top_;
+		}
+
+	private:
+		bool CAS(Node* volatile& trg, Node* expected, Node* desired) {
+			return std::atomic_compare_exchange_strong(
+				reinterpret_cast<volatile std::atomic<Node*>*>(&trg),
+				&expected, desired);
+		}
+
+		NodePool<Node>& pool_;
+		alignas(std::hardware_destructive_interference_size) Node* volatile top_{};
+	};
+
+	/* Relaxed stack built on the window of TSWD.
+	Each thread pushes onto its own partial stack, stamping nodes above the window,
+	and advances the window by depth once its top reaches depth above it.
+	A pop takes the top of any partial stack stamped no more than depth below the window.
+	When no top lies in the window, the popper moves the window down to the highest top it saw,
+	so pops follow the newest stamps while every partial stack contributes at most
+	about 2 * depth candidates. Enq and Deq are provided so that it runs in the queue benchmarks. */
+	template<class T = int, class Instrumentation = benchmark::NullRelaxationDistanceManager>
+		requires std::movable<T> and std::default_initializable<T>
+	class TSWDStack {
+	public:
+		using Node = tswd::Node<T>;
+
+		TSWDStack(int num_thread, int depth)
+			: depth_{ static_cast<uint64_t>(depth) }, pool_{ num_thread }, ebr_{ num_thread, pool_ } {
+			stacks_.reserve(num_thread);
+			for (int i = 0; i < num_thread; ++i) {
+				stacks_.emplace_back(pool_);
+			}
+		}
+
+		void CheckRelaxationDistance() {
+			rdm_.CheckRelaxationDistance();
+		}
+
+		auto GetRelaxationDistance() {
+			return rdm_.GetRelaxationDistance();
+		}
+
+		auto GetNumAllocation() const {
+			return pool_.GetNumAllocation();
+		}
+
+		auto GetPeakNumRetired() const {
+			return ebr_.GetPeakNumRetired();
+		}
+
+		void Push(T v) {
+			auto node = pool_.New(std::move(v));
+			auto& ps = stacks_[MyThreadID::Get()];
+
+			ebr_.StartOp();
+			auto window_ts = window_.time_stamp;
+			auto top_ts = ps.Push(node, window_ts, rdm_);
+			if (top_ts >= window_ts + depth_) {
+				window_.CAS(window_ts, window_ts + depth_);
+			}
+			ebr_.EndOp();
+		}
+
+		std::optional<T> Pop() {
+			auto num_stack = stacks_.size();
+			size_t home = MyThreadID::Get();
+
+			ebr_.StartOp();
+			while (true) {
+				auto window_ts = window_.time_stamp;
+				auto min_ts = window_ts > depth_ ? window_ts - depth_ : 0;
+				Node* max_top{};
+				auto id = home;
+				for (size_t i = 0; i < num_stack; ++i) {
+					auto [value, top] = stacks_[id].TryPop(ebr_, min_ts, rdm_);
+					if (value.has_value()) {
+						ebr_.EndOp();
+						return value;
+					}
+					if (nullptr != top and (nullptr == max_top or top->time_stamp > max_top->time_stamp)) {
+						max_top = top;
+					}
+					id = (id + 1) % num_stack;
+				}
+
+				if (nullptr == max_top) {
+					bool is_empty{ true };
+					for (const auto& ps : stacks_) {
+						if (not ps.IsEmpty()) {
+							is_empty = false;
+							break;
+						}
+					}
+					if (is_empty) {
+						ebr_.EndOp();
+						return std::nullopt;
+					}
+					continue;
+				}
+
+				window_.CAS(window_ts, max_top->time_stamp);
+			}
+		}
+
+		void Enq(T v) {
+			Push(std::move(v));
+		}
+
+		std::optional<T> Deq() {
+			return Pop();
+		}
+
+	private:
+		uint64_t depth_;
+		NodePool<Node> pool_;
+		std::vector<PartialStack<T>> stacks_;
+		EBR<Node> ebr_;
+		Window window_;
+		[[no_unique_address]] Instrumentation rdm_;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -6,23 +6,26 @@
 #include <vector>
 #include <array>
 #include <chrono>
+#include <concepts>
 #include "ebr.h"
 #include "random.h"
 #include "relaxation_distance.h"
 
 namespace lf::twodd {
+	template<class T>
 	struct Node{
 		Node() = default;
-		Node(int v) : v{ v } {}
+		Node(T v) : v{ std::move(v) } {}
 
 		Node* volatile next{};
 		uint64_t retire_epoch{};
 		uint64_t cnt{};
-		int v{};
+		T v{};
 	};
 
+	template<class T>
 	struct alignas(std::hardware_destructive_interference_size) PaddedPtr {
-		Node* volatile ptr{};
+		Node<T>* volatile ptr{};
 	};
 
 	struct alignas(std::hardware_destructive_interference_size) Window {
@@ -38,13 +41,17 @@ namespace lf::twodd {
 		volatile uint64_t max{};
 	};
 
+	template<class T = int, class Instrumentation = benchmark::NullRelaxationDistanceManager>
+		requires std::movable<T> and std::default_initializable<T>
 	class TwoDd {
 	public:
+		using Node = twodd::Node<T>;
+
 		TwoDd(int num_queue, int num_thread, int depth)
-			: depth_{ depth }, width_{ num_queue }, heads_(num_queue), tails_(num_queue)
-			, ebr_{ num_thread }, window_get_{ depth }, window_put_{ depth } {
+			: depth_{ depth }, width_{ num_queue }, pool_{ num_thread }, heads_(num_queue), tails_(num_queue)
+			, window_get_{ depth }, window_put_{ depth }, ebr_{ num_thread, pool_ } {
 			for (int i = 0; i < num_queue; ++i) {
-				tails_[i].ptr = new Node;
+				tails_[i].ptr = pool_.New();
 				heads_[i].ptr = tails_[i].ptr;
 			}
 		}
@@ -55,24 +62,47 @@ namespace lf::twodd {
 				while (nullptr != head->next) {
 					Node* t = head;
 					head = head->next;
-					delete t;
+					pool_.Destroy(t);
 				}
-				delete head;
+				pool_.Destroy(head);
 			}
 		}
 
 		void CheckRelaxationDistance() {
 			rdm_.CheckRelaxationDistance();
 		}
+
+		/* The put window only advances once every tail has reached its top, so no tail falls more than depth
+		below it, and an element enqueued before one with count c has a count of at most c + depth - 1.
+		The get window only advances to G when some sub-queue is nonempty and every nonempty one has a head
+		of at least G - depth, so the put window P then exceeds G - depth. A sub-queue empty at that moment
+		has its head at its tail, at least P - depth > G - 2 * depth. A dequeue with count c <= G thus finds
+		heads of at least c - 2 * depth + 1 elsewhere, and at most 3 * depth - 2 elements ahead of it
+		in each other sub-queue. */
+		uint64_t GetRelaxationBound() const {
+			return static_cast<uint64_t>(width_ - 1) * (3 * depth_ - 2);
+		}
+
+		void CheckRelaxationBound(uint64_t bound, uint64_t tolerance) {
+			rdm_.CheckRelaxationBound(bound, tolerance);
+		}
 		
 		auto GetRelaxationDistance() {
 			return rdm_.GetRelaxationDistance();
 		}
 
-		void Enq(int v) {
+		auto GetNumAllocation() const {
+			return pool_.GetNumAllocation();
+		}
+
+		auto GetPeakNumRetired() const {
+			return ebr_.GetPeakNumRetired();
+		}
+
+		void Enq(T v) {
 			bool has_contented{};
 			ebr_.StartOp();
-			auto node = new Node{ v };
+			auto node = pool_.New(std::move(v));
 			Node* tail;
 			while (true) {
 				tail = GetTail(has_contented);
@@ -80,10 +110,9 @@ namespace lf::twodd {
 				auto next = tail->next;
 
 				if (nullptr == next) {
-					rdm_.LockEnq();
+					auto stamp = rdm_.Stamp();
 					if (true == CAS(tail->next, nullptr, node)) {
-						rdm_.Enq(node);
-						rdm_.UnlockEnq();
+						rdm_.Enq(node, stamp);
 						if (false == CAS(tails_[index_].ptr, tail, node)) {
 							has_contented = true;
 						}
@@ -93,7 +122,6 @@ namespace lf::twodd {
 
 						return;
 					}
-					rdm_.UnlockEnq();
 					has_contented = true;
 				} else {
 					if (false == CAS(tails_[index_].ptr, tail, next)) {
@@ -103,7 +131,7 @@ namespace lf::twodd {
 			}
 		}
 
-		std::optional<int> Deq() {
+		std::optional<T> Deq() {
 			bool has_contented{};
 			ebr_.StartOp();
 			while (true) {
@@ -121,15 +149,13 @@ namespace lf::twodd {
 						}
 					}
 				} else {
-					rdm_.LockDeq();
 					if (true == CAS(heads_[index_].ptr, head, first)) {
-						rdm_.Deq(first);
-						rdm_.UnlockDeq();
+						rdm_.Deq(first, &heads_[index_]);
+						std::optional<T> value{ std::move(first->v) };
 						ebr_.Retire(head);
 						ebr_.EndOp();
-						return first->v;
+						return value;
 					}
-					rdm_.UnlockDeq();
 					has_contented = true;
 				}
 			}
@@ -225,15 +251,17 @@ namespace lf::twodd {
 
 		static thread_local int index_;
 		int depth_, width_;
-		std::vector<PaddedPtr> heads_;
-		std::vector<PaddedPtr> tails_;
+		NodePool<Node> pool_;
+		std::vector<PaddedPtr<T>> heads_;
+		std::vector<PaddedPtr<T>> tails_;
 		Window window_get_;
 		Window window_put_;
 		EBR<Node> ebr_;
-		benchmark::RelaxationDistanceManager rdm_;
+		[[no_unique_address]] Instrumentation rdm_;
 	};
 
-	inline thread_local int TwoDd::index_{};
+	template<class T, class Instrumentation> requires std::movable<T> and std::default_initializable<T>
+	inline thread_local int TwoDd<T, Instrumentation>::index_{};
 }
 
 #endif
\ No newline at end of file